@@ -0,0 +1,64 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/file_log_consumer.h>
+#include <loggerpp/shared_tags_logger.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+
+using namespace charivari_ltd;
+
+template <typename traits_t>
+static void file_log_consumer_push(benchmark::State& state)
+{
+	const std::string path = "benchmark_file_log_consumer.log";
+	std::remove(path.c_str());
+	{
+		loggerpp::details::file_log_consumer<traits_t> consumer(path);
+		const auto tags = traits_t::make_tags_handle(typename traits_t::tags_t{
+			{loggerpp::constants::key_time, std::chrono::system_clock::now()},
+			{loggerpp::constants::key_level, loggerpp::level::info},
+			{loggerpp::constants::key_message, std::string{"Hello, world!"}},
+			{"entity", std::string{"benchmark"}},
+			{"index", std::uint64_t{42}},
+		});
+		for (auto _ : state)
+			consumer.push(tags);
+	}
+	std::remove(path.c_str());
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(file_log_consumer_push, loggerpp::default_log_traits);
+BENCHMARK_TEMPLATE(file_log_consumer_push, loggerpp::shared_tags_log_traits);
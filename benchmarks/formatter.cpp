@@ -0,0 +1,68 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/log_formatter.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace charivari_ltd;
+
+static void default_formatter_format_no_args(benchmark::State& state)
+{
+	const std::string format = "Hello, world!";
+	for (auto _ : state)
+		benchmark::DoNotOptimize(loggerpp::default_formatter::format(format));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(default_formatter_format_no_args);
+
+static void default_formatter_format_int(benchmark::State& state)
+{
+	const std::string format = "msg: {}";
+	std::int64_t index = 0;
+	for (auto _ : state)
+		benchmark::DoNotOptimize(loggerpp::default_formatter::format(format, ++index));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(default_formatter_format_int);
+
+static void default_formatter_format_mixed(benchmark::State& state)
+{
+	const std::string format = "user {} did {} in {} ms";
+	const std::string user = "somebody";
+	std::int64_t index = 0;
+	for (auto _ : state)
+		benchmark::DoNotOptimize(loggerpp::default_formatter::format(format, user, ++index, 0.25));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(default_formatter_format_mixed);
@@ -0,0 +1,227 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+//Producer latency harness: K producer threads call logger.info at a fixed rate
+//while a null, file or slow consumer is attached, and per-call latency percentiles are printed.
+//A throttled call is measured from the later of its scheduled time and the wakeup, so the oversleep of timer is not counted;
+//the lag of calls behind the schedule (stalls of producer included) is printed separately.
+//
+//Usage: latency [producers] [rate per producer, records/s; 0 is unthrottled] [seconds] [null|file|slow|all]
+
+#include <loggerpp/shared_tags_logger.h>
+#include <loggerpp/file_log_consumer.h>
+#include <loggerpp/log_metrics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace charivari_ltd;
+
+namespace
+{
+	struct options
+	{
+		std::size_t producers = 4;
+		std::size_t rate = 100'000;
+		std::chrono::milliseconds duration {2000};
+		std::string consumer = "all";
+	};
+
+	const std::vector<std::string> consumers = {"null", "file", "slow"};
+
+	const std::string log_file_name = "latency.log";
+
+	struct result
+	{
+		loggerpp::histogram_snapshot latency;
+		loggerpp::histogram_snapshot lag;	//empty for unthrottled run
+	};
+
+	//Each producer records to its own histograms, so producers don't contend on the buckets
+	struct producer_histograms
+	{
+		loggerpp::histogram latency;
+		loggerpp::histogram lag;
+	};
+
+	void merge(loggerpp::histogram_snapshot& to, const loggerpp::histogram_snapshot& from)
+	{
+		for (std::size_t index = 0; index < loggerpp::histogram_snapshot::buckets_count; ++index)
+			to.buckets[index] += from.buckets[index];
+		to.count += from.count;
+		to.sum += from.sum;
+		to.max = std::max(to.max, from.max);
+	}
+
+	template <typename logger_t>
+	result run_producers(const logger_t& root, const options& opts)
+	{
+		std::vector<std::unique_ptr<producer_histograms>> histograms;
+		for (std::size_t producer = 0; producer < opts.producers; ++producer)
+			histograms.push_back(std::make_unique<producer_histograms>());
+		const auto throttled = opts.rate != 0;
+		const auto period = throttled ? std::chrono::nanoseconds(std::chrono::nanoseconds(std::chrono::seconds(1)) / opts.rate) : std::chrono::nanoseconds(0);
+		const auto start = std::chrono::steady_clock::now();
+		const auto stop = start + opts.duration;
+
+		std::vector<std::thread> producers;
+		for (std::size_t producer = 0; producer < opts.producers; ++producer)
+			producers.emplace_back([&root, histograms = histograms[producer].get(), throttled, period, start, stop, producer] {
+				const auto ref = extend_logger(root, {{"producer", std::uint64_t{producer}}});
+				auto next = start;
+				for (std::uint64_t index = 0; ; ++index, next += period)
+				{
+					if (throttled)
+					{
+						if (next >= stop)
+							break;
+						std::this_thread::sleep_until(next);
+					}
+					else if (std::chrono::steady_clock::now() >= stop)
+						break;
+					const auto before = throttled ? std::max(next, std::chrono::steady_clock::now()) : std::chrono::steady_clock::now();
+					ref.info("x {}", index);
+					const auto after = std::chrono::steady_clock::now();
+					histograms->latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count());
+					if (throttled)
+						histograms->lag.record(std::chrono::duration_cast<std::chrono::nanoseconds>(before - next).count());
+				}
+			});
+		for (auto& producer : producers)
+			producer.join();
+
+		result total;
+		for (const auto& h : histograms)
+		{
+			merge(total.latency, h->latency.get_snapshot());
+			merge(total.lag, h->lag.get_snapshot());
+		}
+		return total;
+	}
+
+	template <typename traits_t>
+	typename loggerpp::logger_base<traits_t>::dispatcher_t::consumer_fn build_consumer(const std::string& name)
+	{
+		if (name == "file")
+			return loggerpp::build_base_file_log_consumer<traits_t>(log_file_name);
+		if (name == "slow")
+			return [] (const auto&) {
+				std::this_thread::sleep_for(std::chrono::microseconds(20));
+			};
+		return [] (const auto&) {};
+	}
+
+	void print_header()
+	{
+		std::cout
+			<< std::left << std::setw(24) << "traits"
+			<< std::setw(8) << "sink"
+			<< std::right << std::setw(12) << "records"
+			<< std::setw(12) << "p50, ns"
+			<< std::setw(12) << "p99, ns"
+			<< std::setw(12) << "p99.9, ns"
+			<< std::setw(12) << "max, ns"
+			<< std::setw(16) << "lag p50, ns"
+			<< std::setw(16) << "lag p99, ns" << std::endl;
+	}
+
+	void print_row(const std::string& traits, const std::string& consumer, const result& r)
+	{
+		std::cout
+			<< std::left << std::setw(24) << traits
+			<< std::setw(8) << consumer
+			<< std::right << std::setw(12) << r.latency.count
+			<< std::setw(12) << r.latency.percentile(0.5)
+			<< std::setw(12) << r.latency.percentile(0.99)
+			<< std::setw(12) << r.latency.percentile(0.999)
+			<< std::setw(12) << r.latency.max
+			<< std::setw(16) << r.lag.percentile(0.5)
+			<< std::setw(16) << r.lag.percentile(0.99) << std::endl;
+	}
+
+	template <typename traits_t>
+	void run(const std::string& traits, const options& opts)
+	{
+		for (const auto& consumer : consumers)
+		{
+			if (opts.consumer != "all" && opts.consumer != consumer)
+				continue;
+			std::remove(log_file_name.c_str());
+			result r;
+			{
+				loggerpp::logger_base<traits_t> root;
+				auto subscription = root >> build_consumer<traits_t>(consumer);
+				r = run_producers(root, opts);
+			}//waiting here while the backlog is passed to consumer
+			print_row(traits, consumer, r);
+		}
+		std::remove(log_file_name.c_str());
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	options opts;
+	if (argc > 1)
+		opts.producers = std::stoul(argv[1]);
+	if (argc > 2)
+		opts.rate = std::stoul(argv[2]);
+	if (argc > 3)
+		opts.duration = std::chrono::seconds(std::stoul(argv[3]));
+	if (argc > 4)
+		opts.consumer = argv[4];
+	if (opts.consumer != "all" && std::find(consumers.begin(), consumers.end(), opts.consumer) == consumers.end())
+	{
+		std::cerr << "unknown consumer " << opts.consumer << "; expected null, file, slow or all" << std::endl;
+		return 1;
+	}
+
+	std::cout << opts.producers << " producers, ";
+	if (opts.rate != 0)
+		std::cout << opts.rate << " records/s each, ";
+	else
+		std::cout << "unthrottled, ";
+	std::cout << opts.duration.count() << " ms" << std::endl;
+	print_header();
+	run<loggerpp::default_log_traits>("default_log_traits", opts);
+	run<loggerpp::shared_tags_log_traits>("shared_tags_log_traits", opts);
+	return 0;
+}
@@ -0,0 +1,136 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/shared_tags_logger.h>
+
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+using namespace charivari_ltd;
+
+namespace
+{
+	template <typename traits_t>
+	typename traits_t::tags_t make_context_tags(std::size_t count)
+	{
+		typename traits_t::tags_t tags;
+		for (std::size_t index = 0; index < count; ++index)
+			tags.push_back({"key" + std::to_string(index), std::string{"value"}});
+		return tags;
+	}
+
+	template <typename logger_t>
+	std::size_t extend_recursive(const logger_t& ref, std::int64_t depth)
+	{
+		if (depth == 0)
+			return ref.get_tags().size();
+		const auto next = extend_logger(ref, {{"depth", depth}});
+		return extend_recursive(next, depth - 1);
+	}
+}
+
+//Producer side of logger_base::log with 0, 5 and 20 context tags
+template <typename traits_t>
+static void logger_base_log(benchmark::State& state)
+{
+	using logger_t = loggerpp::logger_base<traits_t>;
+
+	logger_t root;
+	auto subscription = root >> [] (const auto&) {};
+	auto ref = extend_logger(root, make_context_tags<traits_t>(state.range(0)));
+
+	std::int64_t index = 0;
+	for (auto _ : state)
+		ref.info("x {}", ++index);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(logger_base_log, loggerpp::default_log_traits)->Arg(0)->Arg(5)->Arg(20);
+BENCHMARK_TEMPLATE(logger_base_log, loggerpp::shared_tags_log_traits)->Arg(0)->Arg(5)->Arg(20);
+
+//Cost of extend_logger chain of given depth, each level adds one tag
+template <typename traits_t>
+static void extend_logger_depth(benchmark::State& state)
+{
+	using logger_t = loggerpp::logger_base<traits_t>;
+
+	logger_t root;
+	for (auto _ : state)
+		benchmark::DoNotOptimize(extend_recursive(root, state.range(0)));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(extend_logger_depth, loggerpp::default_log_traits)->Arg(1)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(extend_logger_depth, loggerpp::shared_tags_log_traits)->Arg(1)->Arg(4)->Arg(16);
+
+//The dispatcher is created before the threads of benchmark start and destroyed after they finish
+template <typename traits_t>
+struct dispatcher_push_fixture
+{
+	using dispatcher_t = typename loggerpp::logger_base<traits_t>::dispatcher_t;
+
+	static inline std::shared_ptr<dispatcher_t> dispatcher;
+	static inline std::shared_ptr<typename dispatcher_t::consumer_fn> subscription;
+
+	static void setup(const benchmark::State&)
+	{
+		dispatcher = std::make_shared<dispatcher_t>();
+		subscription = dispatcher->subscribe([] (const auto&) {});
+	}
+
+	static void teardown(const benchmark::State&)
+	{
+		subscription.reset();
+		dispatcher.reset();
+	}
+};
+
+//Throughput of dispatcher::push from 1 to N producer threads into one dispatcher
+template <typename traits_t>
+static void dispatcher_push(benchmark::State& state)
+{
+	using logger_t = loggerpp::logger_base<traits_t>;
+
+	const logger_t ref(dispatcher_push_fixture<traits_t>::dispatcher, {});
+	std::int64_t index = 0;
+	for (auto _ : state)
+		ref.info("x {}", ++index);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(dispatcher_push, loggerpp::default_log_traits)
+	->Setup(dispatcher_push_fixture<loggerpp::default_log_traits>::setup)
+	->Teardown(dispatcher_push_fixture<loggerpp::default_log_traits>::teardown)
+	->ThreadRange(1, std::max(1u, std::thread::hardware_concurrency()))->UseRealTime();
+BENCHMARK_TEMPLATE(dispatcher_push, loggerpp::shared_tags_log_traits)
+	->Setup(dispatcher_push_fixture<loggerpp::shared_tags_log_traits>::setup)
+	->Teardown(dispatcher_push_fixture<loggerpp::shared_tags_log_traits>::teardown)
+	->ThreadRange(1, std::max(1u, std::thread::hardware_concurrency()))->UseRealTime();
@@ -0,0 +1,55 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/shared_tags_logger.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace charivari_ltd;
+
+//Lookup of the last tag among given count of tags of the record handle
+template <typename traits_t>
+static void get_tag_lookup(benchmark::State& state)
+{
+	typename traits_t::tags_t tags;
+	for (std::int64_t index = 0; index < state.range(0); ++index)
+		tags.push_back({"key" + std::to_string(index), std::uint64_t(index)});
+	const auto handle = traits_t::make_tags_handle(std::move(tags));
+	const std::string key = "key" + std::to_string(state.range(0) - 1);
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(loggerpp::get_tag<std::uint64_t>(traits_t::extract_tags(handle), key));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(get_tag_lookup, loggerpp::default_log_traits)->Arg(1)->Arg(8)->Arg(32);
+BENCHMARK_TEMPLATE(get_tag_lookup, loggerpp::shared_tags_log_traits)->Arg(1)->Arg(8)->Arg(32);
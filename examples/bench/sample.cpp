@@ -39,10 +39,11 @@ using namespace charivari_ltd;
 
 static const std::size_t messages_count = 1'000'000;
 
-int main () {
-	logger root;
+template <typename logger_t>
+std::chrono::system_clock::duration bench(std::size_t& total_size)
+{
+	logger_t root;
 
-	std::size_t total_size = 0;
 	const auto start = std::chrono::system_clock::now();
 	{
 		auto counter_subscription = root >> [&total_size](const auto& tags) {
@@ -53,20 +54,34 @@ int main () {
 		for (std::size_t index = 0; index < messages_count; ++index)
 			root.info("msg: {}", index);
 	}
-	const auto end = std::chrono::system_clock::now();
+	return std::chrono::system_clock::now() - start;
+}
 
-	const auto delta = end - start;
+template <typename logger_t>
+void report(const logger_t& root, const std::string& name, std::size_t total_size, std::chrono::system_clock::duration delta)
+{
 	const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(delta);
 	const auto mills = std::chrono::duration_cast<std::chrono::milliseconds>(delta - seconds);
 
+	root.info("{}: total value size for {} messages is {}; calculated for {}.{}", name, messages_count, total_size, seconds.count(), mills.count());
+}
+
+int main () {
+	std::size_t async_total_size = 0;
+	const auto async_delta = bench<logger>(async_total_size);
+
+	std::size_t sync_total_size = 0;
+	const auto sync_delta = bench<sync_logger>(sync_total_size);
+
+	sync_logger root;
 	auto subscription = root >> [](const auto& tags) {
 		for (const auto& tag : tags)
 			std::cout << loggerpp::to_string(tag.value) << '\t';
 		std::cout << std::endl;
 	};
 
-	root.info("Total value size for {} messages is {}; calculated for {}.{}", messages_count, total_size, seconds.count(), mills.count());
+	report(root, "async", async_total_size, async_delta);
+	report(root, "sync", sync_total_size, sync_delta);
 
 	return 0;
 }
-
@@ -0,0 +1,305 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "logger.h"
+#include "log_schema.h"
+#include "binary_log_format.h"
+
+#include <utils/noncopyable.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace charivari_ltd::loggerpp
+{
+	struct binary_log_options
+	{
+		std::size_t block_records = 4096;		//a block is written when it has so many records
+		std::size_t block_bytes = 1 << 20;		//or so many bytes
+	};
+
+	//Writes records to block-structured file which is read by binary_log_reader; see binary_log_format.h.
+	//Records are kept in memory until the block is full, flush or destruction.
+	//An existing file is appended: its index is loaded and rewritten on close.
+	template <typename traits_t>
+	class binary_log_writer :
+		public utils::noncopyable
+	{
+	public:
+		using key_t = typename traits_t::key_t;
+		using tags_handle_t = typename traits_t::tags_handle_t;
+
+	public:
+		explicit binary_log_writer(const std::string& path, const binary_log_options& options = {}) :
+			options(options)
+		{
+			const auto size = std::filesystem::exists(path) ? std::filesystem::file_size(path) : 0;
+			if (size == 0)
+			{
+				file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+				details::binary_log::buffer_writer out(records);
+				out.put(details::binary_log::file_magic);
+				out.put(details::binary_log::version);
+				write(records);
+				records.clear();
+				offset = details::binary_log::file_header_size;
+			}
+			else
+			{
+				{
+					std::ifstream in(path, std::ios::binary);
+					auto index = details::binary_log::load_index(in, size);
+					blocks = std::move(index.blocks);
+					offset = index.end;
+				}
+				//the old index and a torn block of crashed process are overwritten
+				std::filesystem::resize_file(path, offset);
+				file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+				file.seekp(static_cast<std::streamoff>(offset));
+			}
+			if (!file)
+				throw std::runtime_error("binary log: can't open " + path);
+		}
+
+		~binary_log_writer()
+		{
+			try {
+				write_block();
+				write_index();
+			} catch (...) {
+			}
+		}
+
+	public:
+		void push(const tags_handle_t& tags_handle)
+		{
+			const auto& tags = traits_t::extract_tags(tags_handle);
+
+			//records of LOGGERPP_LOG are written with rendered message instead of site id and arguments,
+			//so readers don't depend on the site registry of the writing process
+			const bool site = get_site_id(tags) != nullptr;
+			const auto end = tags.size() - get_site_args_count(tags);
+			details::binary_log::buffer_writer out(records);
+			const auto put_tag = [this, &out, &tags, site] (std::size_t index) {
+				if (site && index == constants::index_message)
+				{
+					out.put(get_key_index(key_t{std::string(constants::key_message)}));
+					out.put_value(get_message(tags));
+				}
+				else
+				{
+					out.put(get_key_index(tags[index].key));
+					out.put_value(tags[index].value);
+				}
+			};
+
+			out.put(static_cast<std::uint32_t>(end + details::get_schema_tags_count<typename traits_t::tags_t>()));
+			std::size_t index = 0;
+			if (const auto* context = details::get_context<traits_t>(tags_handle); context != nullptr && constants::index_guaratee_size + context->count <= end)
+			{
+				for (; index < constants::index_guaratee_size; ++index)
+					put_tag(index);
+				//encoded values of context tags are taken from the cache, key indexes depend on the block
+				const auto& values = context->cache.template get<details::binary_log::context_format>([&tags, context] {
+					std::string result;
+					details::binary_log::buffer_writer values(result);
+					for (std::size_t i = 0; i < context->count; ++i)
+					{
+						std::string value;
+						details::binary_log::buffer_writer(value).put_value(tags[constants::index_guaratee_size + i].value);
+						values.put(static_cast<std::uint32_t>(value.size()));
+						result.append(value);
+					}
+					return result;
+				});
+				std::size_t position = 0;
+				for (const auto context_end = index + context->count; index < context_end; ++index)
+				{
+					out.put(get_key_index(tags[index].key));
+					std::uint32_t size = 0;
+					std::memcpy(&size, values.data() + position, sizeof(size));
+					records.append(values, position + sizeof(size), size);
+					position += sizeof(size) + size;
+				}
+			}
+			for (; index < end; ++index)
+				put_tag(index);
+			details::for_each_schema_tag<typename traits_t::value_t>(tags, [this, &out] (const char* key, const auto& value) {
+				out.put(get_key_index(key_t{std::string(key)}));
+				out.put_value(value);
+			});
+
+			std::int64_t time = 0;
+			if (tags.size() > constants::index_time)
+				if (const auto t = std::get_if<std::chrono::system_clock::time_point>(&tags[constants::index_time].value))
+					time = details::binary_log::to_nanoseconds(*t);
+			if (tags.size() > constants::index_level)
+				if (const auto lvl = std::get_if<level>(&tags[constants::index_level].value))
+					levels |= details::binary_log::get_level_bit(*lvl);
+			min_time = std::min(min_time, time);
+			max_time = std::max(max_time, time);
+
+			if (++count >= options.block_records || records.size() >= options.block_bytes)
+				write_block();
+		}
+
+		//Writes the current block; the index is written on destruction only
+		void flush()
+		{
+			write_block();
+			file.flush();
+		}
+
+	private:
+		std::uint32_t get_key_index(const key_t& key)
+		{
+			const auto [iter, inserted] = keys.emplace(key, static_cast<std::uint32_t>(keys_order.size()));
+			if (inserted)
+			{
+				keys_order.push_back(&iter->first);
+				key_bits |= details::binary_log::get_key_bit(to_string(key));
+			}
+			return iter->second;
+		}
+
+		void write_block()
+		{
+			if (count == 0)
+				return;
+
+			std::string body;
+			details::binary_log::buffer_writer out(body);
+			out.put(static_cast<std::uint32_t>(count));
+			out.put(min_time);
+			out.put(max_time);
+			out.put(levels);
+			out.put(key_bits);
+			out.put(static_cast<std::uint32_t>(keys_order.size()));
+			for (const auto key : keys_order)
+				out.put_value(*key);
+			body.append(records);
+			write_chunk(details::binary_log::block_magic, body);
+			blocks.push_back({offset - details::binary_log::chunk_header_size - body.size(), min_time, max_time, levels, key_bits});
+
+			records.clear();
+			keys.clear();
+			keys_order.clear();
+			count = 0;
+			min_time = std::numeric_limits<std::int64_t>::max();
+			max_time = std::numeric_limits<std::int64_t>::min();
+			levels = 0;
+			key_bits = 0;
+		}
+
+		void write_index()
+		{
+			std::string body;
+			details::binary_log::buffer_writer out(body);
+			out.put(static_cast<std::uint32_t>(blocks.size()));
+			for (const auto& block : blocks)
+			{
+				out.put(block.offset);
+				out.put(block.min_time);
+				out.put(block.max_time);
+				out.put(block.levels);
+				out.put(block.key_bits);
+			}
+			const auto index_offset = offset;
+			write_chunk(details::binary_log::index_magic, body);
+
+			body.clear();
+			out.put(index_offset);
+			write_chunk(details::binary_log::tail_magic, body);
+			file.flush();
+		}
+
+		void write_chunk(std::uint32_t magic, const std::string& body)
+		{
+			std::string header;
+			details::binary_log::buffer_writer out(header);
+			out.put(magic);
+			out.put(static_cast<std::uint64_t>(body.size()));
+			write(header);
+			write(body);
+		}
+
+		void write(const std::string& data)
+		{
+			file.write(data.data(), static_cast<std::streamsize>(data.size()));
+			if (!file)
+				throw std::runtime_error("binary log: write failed");
+			offset += data.size();
+		}
+
+	private:
+		const binary_log_options options;
+		std::ofstream file;
+		std::uint64_t offset = 0;
+		std::vector<details::binary_log::block_info> blocks;
+
+		std::string records;
+		std::size_t count = 0;
+		std::int64_t min_time = std::numeric_limits<std::int64_t>::max();
+		std::int64_t max_time = std::numeric_limits<std::int64_t>::min();
+		std::uint32_t levels = 0;
+		std::uint64_t key_bits = 0;
+		std::map<key_t, std::uint32_t> keys;
+		std::vector<const key_t*> keys_order;
+	};
+
+	template <typename traits_t>
+	inline auto build_base_binary_log_consumer(const std::string& path, const binary_log_options& options = {})
+	{
+		auto writer = std::make_shared<binary_log_writer<traits_t>>(path, options);
+		return details::make_flushable_consumer([writer] (const typename traits_t::tags_handle_t& tags_handle) {
+			writer->push(tags_handle);
+		}, [writer] {
+			writer->flush();
+		});
+	}
+
+	inline auto build_binary_log_consumer(const std::string& path, const binary_log_options& options = {})
+	{
+		return build_base_binary_log_consumer<default_log_traits>(path, options);
+	}
+} //namespace charivari_ltd::loggerpp
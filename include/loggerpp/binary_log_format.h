@@ -0,0 +1,429 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "log_base.h"
+
+#include <utils/bool_t.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+//Layout of binary log files; integers are stored in native byte order.
+//
+//file:   "LPPB" version:u32 chunk*
+//chunk:  magic:u32 size:u64 body[size]
+//block:  "BLCK" records:u32 min_time:i64 max_time:i64 levels:u32 key_bits:u64 keys:u32 value[keys] record[records]
+//record: tags:u32 (key_index:u32 value)[tags]
+//index:  "INDX" blocks:u32 (offset:u64 min_time:i64 max_time:i64 levels:u32 key_bits:u64)[blocks]
+//tail:   "TAIL" index_offset:u64; the last chunk of a properly closed file
+//value:  type:u8 data
+//
+//Times are nanoseconds since epoch; levels is bitmap of levels of the block;
+//key_bits is a bloom filter of keys of the block (one bit per key, see get_key_bit).
+//The index is rewritten on close; files without the tail are recovered by scan of chunks.
+namespace charivari_ltd::loggerpp::details::binary_log
+{
+	static constexpr std::uint32_t file_magic = 0x4250504C;	//"LPPB"
+	static constexpr std::uint32_t version = 2;
+	static constexpr std::uint32_t block_magic = 0x4B434C42;	//"BLCK"
+	static constexpr std::uint32_t index_magic = 0x58444E49;	//"INDX"
+	static constexpr std::uint32_t tail_magic = 0x4C494154;	//"TAIL"
+
+	static constexpr std::uint64_t file_header_size = 8;
+	static constexpr std::uint64_t chunk_header_size = 12;
+	static constexpr std::uint64_t tail_size = chunk_header_size + 8;
+
+	enum class value_type : std::uint8_t
+	{
+		null,
+		boolean,
+		int64,
+		uint64,
+		real,
+		string,
+		wstring,
+		level,
+		time,
+	};
+
+	//Encoded values of context tags of a logger, see context_cache
+	struct context_format {};
+
+	struct block_info
+	{
+		std::uint64_t offset;
+		std::int64_t min_time;
+		std::int64_t max_time;
+		std::uint32_t levels;
+		std::uint64_t key_bits;
+	};
+
+	inline std::uint32_t get_level_bit(const level& lvl)
+	{
+		return 1u << static_cast<std::uint32_t>(lvl);
+	}
+
+	//FNV-1a of the key name: the bits are stored in files, so the hash doesn't depend on the standard library
+	inline std::uint64_t get_key_bit(const std::string& key)
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		for (const auto c : key)
+			hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+		return std::uint64_t{1} << (hash % 64);
+	}
+
+	inline std::int64_t to_nanoseconds(const std::chrono::system_clock::time_point& time)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+	}
+
+	inline std::chrono::system_clock::time_point from_nanoseconds(std::int64_t ns)
+	{
+		return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+	}
+
+	class buffer_writer
+	{
+	public:
+		explicit buffer_writer(std::string& out) :
+			out(out)
+		{}
+
+		template <typename type_t>
+		void put(const type_t& value)
+		{
+			static_assert(std::is_trivially_copyable_v<type_t>);
+			out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		void put_string(const std::string& value)
+		{
+			put(static_cast<std::uint32_t>(value.size()));
+			out.append(value);
+		}
+
+		void put_wstring(const std::wstring& value)
+		{
+			put(static_cast<std::uint32_t>(value.size()));
+			for (const auto c : value)
+				put(static_cast<std::uint32_t>(c));
+		}
+
+		template <typename value_t>
+		void put_value(const value_t& value)
+		{
+			using type_t = std::decay_t<value_t>;
+			if constexpr (std::is_same_v<type_t, std::nullptr_t>)
+				put(value_type::null);
+			else if constexpr (std::is_same_v<type_t, utils::bool_t>)
+			{
+				put(value_type::boolean);
+				put(static_cast<std::uint8_t>(value ? 1 : 0));
+			}
+			else if constexpr (std::is_same_v<type_t, std::int64_t>)
+			{
+				put(value_type::int64);
+				put(value);
+			}
+			else if constexpr (std::is_same_v<type_t, std::uint64_t>)
+			{
+				put(value_type::uint64);
+				put(value);
+			}
+			else if constexpr (std::is_same_v<type_t, double>)
+			{
+				put(value_type::real);
+				put(value);
+			}
+			else if constexpr (std::is_same_v<type_t, std::string>)
+			{
+				put(value_type::string);
+				put_string(value);
+			}
+			else if constexpr (std::is_same_v<type_t, std::wstring>)
+			{
+				put(value_type::wstring);
+				put_wstring(value);
+			}
+			else if constexpr (std::is_same_v<type_t, level>)
+			{
+				put(value_type::level);
+				put(static_cast<std::uint8_t>(value));
+			}
+			else if constexpr (std::is_same_v<type_t, std::chrono::system_clock::time_point>)
+			{
+				put(value_type::time);
+				put(to_nanoseconds(value));
+			}
+			else
+				static_assert(!std::is_same_v<type_t, type_t>, "type of value is not supported by binary log");
+		}
+
+		template <typename ... types_t>
+		void put_value(const std::variant<types_t...>& value)
+		{
+			std::visit([this] (const auto& v) {
+				put_value(v);
+			}, value);
+		}
+
+	private:
+		std::string& out;
+	};
+
+	//Throws std::runtime_error on truncated data
+	class buffer_reader
+	{
+	public:
+		buffer_reader(const char* data, std::size_t size) :
+			data(data),
+			size(size)
+		{}
+
+		bool empty() const
+		{
+			return position == size;
+		}
+
+		//Throws std::runtime_error if the rest of data can't hold count items of item_size bytes at least
+		void check_count(std::uint64_t count, std::size_t item_size) const
+		{
+			if (count > (size - position) / item_size)
+				throw std::runtime_error("binary log: bad count");
+		}
+
+		std::uint32_t get_count(std::size_t item_size)
+		{
+			const auto count = get<std::uint32_t>();
+			check_count(count, item_size);
+			return count;
+		}
+
+		template <typename type_t>
+		type_t get()
+		{
+			static_assert(std::is_trivially_copyable_v<type_t>);
+			type_t value;
+			std::memcpy(&value, take(sizeof(value)), sizeof(value));
+			return value;
+		}
+
+		std::string get_string()
+		{
+			const auto length = get<std::uint32_t>();
+			return std::string(take(length), length);
+		}
+
+		std::wstring get_wstring()
+		{
+			const auto length = get_count(sizeof(std::uint32_t));
+			std::wstring value;
+			value.reserve(length);
+			for (std::uint32_t index = 0; index < length; ++index)
+				value.push_back(static_cast<wchar_t>(get<std::uint32_t>()));
+			return value;
+		}
+
+		template <typename value_t>
+		value_t get_value()
+		{
+			switch (get<value_type>())
+			{
+				case value_type::null:
+					return make<value_t>(nullptr);
+				case value_type::boolean:
+					return make<value_t>(utils::bool_t{get<std::uint8_t>() != 0});
+				case value_type::int64:
+					return make<value_t>(get<std::int64_t>());
+				case value_type::uint64:
+					return make<value_t>(get<std::uint64_t>());
+				case value_type::real:
+					return make<value_t>(get<double>());
+				case value_type::string:
+					return make<value_t>(get_string());
+				case value_type::wstring:
+					return make<value_t>(get_wstring());
+				case value_type::level:
+					return make<value_t>(static_cast<level>(get<std::uint8_t>()));
+				case value_type::time:
+					return make<value_t>(from_nanoseconds(get<std::int64_t>()));
+			}
+			throw std::runtime_error("binary log: unknown type of value");
+		}
+
+	private:
+		const char* take(std::size_t count)
+		{
+			if (size - position < count)
+				throw std::runtime_error("binary log: truncated data");
+			const auto result = data + position;
+			position += count;
+			return result;
+		}
+
+		template <typename value_t, typename source_t>
+		static value_t make(source_t&& value)
+		{
+			if constexpr (std::is_constructible_v<value_t, source_t&&>)
+				return value_t(std::forward<source_t>(value));
+			else
+				throw std::runtime_error("binary log: type of value is not supported by traits");
+		}
+
+	private:
+		const char* data;
+		std::size_t size;
+		std::size_t position = 0;
+	};
+
+	//Returns false if the chunk is truncated
+	inline bool read_chunk_header(std::istream& file, std::uint64_t offset, std::uint64_t file_size, std::uint32_t& magic, std::uint64_t& size)
+	{
+		if (offset + chunk_header_size > file_size)
+			return false;
+		file.seekg(static_cast<std::streamoff>(offset));
+		file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		file.read(reinterpret_cast<char*>(&size), sizeof(size));
+		return file && size <= file_size - offset - chunk_header_size;
+	}
+
+	//Reads the first size bytes of the chunk body (the whole body by default)
+	inline bool read_chunk(std::istream& file, std::uint64_t offset, std::uint64_t file_size, std::uint32_t& magic, std::string& body, std::uint64_t size = ~std::uint64_t{0})
+	{
+		std::uint64_t chunk_size = 0;
+		if (!read_chunk_header(file, offset, file_size, magic, chunk_size))
+			return false;
+		body.resize(std::min(size, chunk_size));
+		file.read(body.data(), static_cast<std::streamsize>(body.size()));
+		return static_cast<bool>(file);
+	}
+
+	static constexpr std::uint64_t block_info_size = 4 + 8 + 8 + 4 + 8;
+
+	inline block_info read_block_info(std::uint64_t offset, buffer_reader& reader)
+	{
+		block_info info {offset, 0, 0, 0, 0};
+		reader.get<std::uint32_t>();
+		info.min_time = reader.get<std::int64_t>();
+		info.max_time = reader.get<std::int64_t>();
+		info.levels = reader.get<std::uint32_t>();
+		info.key_bits = reader.get<std::uint64_t>();
+		return info;
+	}
+
+	//Skips the info of block; returns count of records
+	inline std::uint32_t read_block_records(buffer_reader& reader)
+	{
+		const auto records = reader.get<std::uint32_t>();
+		reader.get<std::int64_t>();
+		reader.get<std::int64_t>();
+		reader.get<std::uint32_t>();
+		reader.get<std::uint64_t>();
+		reader.check_count(records, sizeof(std::uint32_t));
+		return records;
+	}
+
+	struct file_index
+	{
+		std::vector<block_info> blocks;
+		std::uint64_t end;		//offset of the first byte after the blocks
+	};
+
+	//Uses the index of the tail if the file is properly closed, scans the blocks otherwise.
+	//Throws std::runtime_error if the file is not a binary log.
+	inline file_index load_index(std::istream& file, std::uint64_t file_size)
+	{
+		std::uint32_t header[2] = {0, 0};
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(header), sizeof(header));
+		if (!file || header[0] != file_magic)
+			throw std::runtime_error("binary log: bad file header");
+		if (header[1] != version)
+			throw std::runtime_error("binary log: unsupported version");
+
+		std::uint32_t magic = 0;
+		std::string body;
+		if (file_size >= file_header_size + tail_size && read_chunk(file, file_size - tail_size, file_size, magic, body) && magic == tail_magic)
+		{
+			buffer_reader tail(body.data(), body.size());
+			const auto index_offset = tail.get<std::uint64_t>();
+			if (read_chunk(file, index_offset, file_size, magic, body) && magic == index_magic)
+			{
+				file_index result {{}, index_offset};
+				buffer_reader reader(body.data(), body.size());
+				const auto count = reader.get_count(8 + 8 + 8 + 4 + 8);
+				for (std::uint32_t index = 0; index < count; ++index)
+				{
+					block_info info;
+					info.offset = reader.get<std::uint64_t>();
+					info.min_time = reader.get<std::int64_t>();
+					info.max_time = reader.get<std::int64_t>();
+					info.levels = reader.get<std::uint32_t>();
+					info.key_bits = reader.get<std::uint64_t>();
+					result.blocks.push_back(info);
+				}
+				return result;
+			}
+		}
+
+		//payloads are not read by the scan
+		file.clear();
+		file_index result {{}, file_header_size};
+		std::uint64_t size = 0;
+		while (read_chunk_header(file, result.end, file_size, magic, size))
+		{
+			if (magic == block_magic)
+			{
+				if (size < block_info_size || !read_chunk(file, result.end, file_size, magic, body, block_info_size))
+					break;
+				buffer_reader reader(body.data(), body.size());
+				result.blocks.push_back(read_block_info(result.end, reader));
+			}
+			else if (magic != index_magic && magic != tail_magic)
+				break;
+			result.end += chunk_header_size + size;
+		}
+		file.clear();
+		return result;
+	}
+} //namespace charivari_ltd::loggerpp::details::binary_log
@@ -0,0 +1,199 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "logger.h"
+#include "binary_log_format.h"
+
+#include <utils/noncopyable.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace charivari_ltd::loggerpp
+{
+	//Records of [from, to) with any of levels and all of keys; empty levels means any level
+	struct binary_log_query
+	{
+		std::optional<std::chrono::system_clock::time_point> from;
+		std::optional<std::chrono::system_clock::time_point> to;
+		std::vector<level> levels;
+		std::vector<std::string> keys;
+	};
+
+	//Reads files of binary_log_writer. Blocks are skipped by the index without reading
+	//when their time range, levels or key bits don't match; the key dictionary of block filters the rest.
+	template <typename traits_t>
+	class binary_log_reader :
+		public utils::noncopyable
+	{
+	public:
+		using key_t = typename traits_t::key_t;
+		using value_t = typename traits_t::value_t;
+		using tag_t = typename traits_t::tag_t;
+		using tags_t = typename traits_t::tags_t;
+
+	public:
+		//Throws std::runtime_error if the file is not a binary log
+		explicit binary_log_reader(const std::string& path) :
+			file(path, std::ios::binary),
+			file_size(0)
+		{
+			if (!file)
+				throw std::runtime_error("binary log: can't open " + path);
+			file_size = std::filesystem::file_size(path);
+			index = details::binary_log::load_index(file, file_size);
+		}
+
+	public:
+		const std::vector<details::binary_log::block_info>& get_blocks() const
+		{
+			return index.blocks;
+		}
+
+		//Passes matched records to consumer(const tags_handle_t&) in order of file; returns count of them
+		template <typename consumer_t>
+		std::size_t read(const binary_log_query& query, consumer_t&& consumer)
+		{
+			const auto from = query.from ? details::binary_log::to_nanoseconds(*query.from) : std::numeric_limits<std::int64_t>::min();
+			const auto to = query.to ? details::binary_log::to_nanoseconds(*query.to) : std::numeric_limits<std::int64_t>::max();
+			std::uint32_t levels = query.levels.empty() ? ~std::uint32_t{0} : 0;
+			for (const auto lvl : query.levels)
+				levels |= details::binary_log::get_level_bit(lvl);
+			std::uint64_t key_bits = 0;
+			for (const auto& key : query.keys)
+				key_bits |= details::binary_log::get_key_bit(key);
+
+			std::size_t count = 0;
+			for (const auto& block : index.blocks)
+			{
+				if (block.max_time < from || block.min_time >= to || (block.levels & levels) == 0 || (block.key_bits & key_bits) != key_bits)
+					continue;
+				count += parse_block(read_body(block), query, from, to, levels, consumer);
+			}
+			return count;
+		}
+
+		//Passes all the records of block to consumer; lets sequential readers keep one block in memory
+		template <typename consumer_t>
+		std::size_t read_block(std::size_t block, consumer_t&& consumer)
+		{
+			return parse_block(read_body(index.blocks.at(block)), {}, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max(), ~std::uint32_t{0}, consumer);
+		}
+
+	private:
+		const std::string& read_body(const details::binary_log::block_info& block)
+		{
+			std::uint32_t magic = 0;
+			if (!details::binary_log::read_chunk(file, block.offset, file_size, magic, body) || magic != details::binary_log::block_magic)
+				throw std::runtime_error("binary log: broken block");
+			return body;
+		}
+
+		template <typename consumer_t>
+		std::size_t parse_block(const std::string& block, const binary_log_query& query, std::int64_t from, std::int64_t to, std::uint32_t levels, consumer_t& consumer)
+		{
+			details::binary_log::buffer_reader reader(block.data(), block.size());
+			const auto records = details::binary_log::read_block_records(reader);
+
+			//counts are checked against the rest of block before anything is reserved
+			std::vector<key_t> keys(reader.get_count(sizeof(details::binary_log::value_type)));
+			for (auto& key : keys)
+				key = reader.get_value<key_t>();
+
+			std::vector<std::uint32_t> required;
+			for (const auto& name : query.keys)
+			{
+				const auto iter = std::find_if(keys.begin(), keys.end(), [&name] (const key_t& key) {
+					return to_string(key) == name;
+				});
+				if (iter == keys.end())
+					return 0;
+				required.push_back(static_cast<std::uint32_t>(iter - keys.begin()));
+			}
+
+			std::size_t count = 0;
+			std::vector<bool> found(keys.size());
+			for (std::uint32_t index = 0; index < records; ++index)
+			{
+				tags_t tags;
+				std::fill(found.begin(), found.end(), false);
+				const auto size = reader.get_count(sizeof(std::uint32_t) + sizeof(details::binary_log::value_type));
+				for (std::uint32_t position = 0; position < size; ++position)
+				{
+					const auto key = reader.get<std::uint32_t>();
+					if (key >= keys.size())
+						throw std::runtime_error("binary log: bad key index");
+					found[key] = true;
+					tags.push_back(tag_t{keys[key], reader.get_value<value_t>()});
+				}
+				if (!is_matched(tags, from, to, levels))
+					continue;
+				if (!std::all_of(required.begin(), required.end(), [&found] (std::uint32_t key) { return found[key]; }))
+					continue;
+				consumer(traits_t::make_tags_handle(std::move(tags)));
+				++count;
+			}
+			return count;
+		}
+
+		static bool is_matched(const tags_t& tags, std::int64_t from, std::int64_t to, std::uint32_t levels)
+		{
+			std::int64_t time = 0;
+			if (tags.size() > constants::index_time)
+				if (const auto t = std::get_if<std::chrono::system_clock::time_point>(&tags[constants::index_time].value))
+					time = details::binary_log::to_nanoseconds(*t);
+			if (time < from || time >= to)
+				return false;
+			if (tags.size() > constants::index_level)
+				if (const auto lvl = std::get_if<level>(&tags[constants::index_level].value))
+					return (details::binary_log::get_level_bit(*lvl) & levels) != 0;
+			return levels == ~std::uint32_t{0};
+		}
+
+	private:
+		std::ifstream file;
+		std::uint64_t file_size;
+		details::binary_log::file_index index;
+		std::string body;
+	};
+} //namespace charivari_ltd::loggerpp
@@ -0,0 +1,401 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "logger.h"
+#include "log_schema.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <variant>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#define LOGGERPP_CRASH_HANDLER_SUPPORTED 1
+#endif
+
+namespace charivari_ltd::loggerpp
+{
+namespace details
+{
+	//Fixed buffer over write(2): no allocations and locks, so it's usable from a signal handler
+	class signal_safe_writer
+	{
+	public:
+		explicit signal_safe_writer(int fd) :
+			fd(fd)
+		{}
+
+		~signal_safe_writer()
+		{
+			flush();
+		}
+
+	public:
+		void write(const char* data, std::size_t length)
+		{
+			while (length != 0)
+			{
+				if (size == buffer.size())
+					flush();
+				const auto count = std::min(length, buffer.size() - size);
+				for (std::size_t index = 0; index < count; ++index)
+					buffer[size + index] = data[index];
+				size += count;
+				data += count;
+				length -= count;
+			}
+		}
+
+		void write(const char* str)
+		{
+			std::size_t length = 0;
+			while (str[length] != '\0')
+				++length;
+			write(str, length);
+		}
+
+		void write(char c)
+		{
+			write(&c, 1);
+		}
+
+		void write_uint(std::uint64_t value)
+		{
+			char digits[20];
+			std::size_t count = 0;
+			do {
+				digits[count++] = static_cast<char>('0' + value % 10);
+				value /= 10;
+			} while (value != 0);
+			while (count != 0)
+				write(digits[--count]);
+		}
+
+		void write_int(std::int64_t value)
+		{
+			if (value < 0)
+			{
+				write('-');
+				write_uint(std::uint64_t{0} - static_cast<std::uint64_t>(value));
+			}
+			else
+				write_uint(static_cast<std::uint64_t>(value));
+		}
+
+		void write_double(double value)
+		{
+			if (value != value)
+				return write("nan");
+			if (value < 0)
+			{
+				write('-');
+				value = -value;
+			}
+			if (value >= 1e19)
+				return write("inf");
+			const auto integer = static_cast<std::uint64_t>(value);
+			write_uint(integer);
+			write('.');
+			auto fraction = static_cast<std::uint64_t>((value - integer) * 1'000'000);
+			for (std::uint64_t divider = 100'000; divider != 0; divider /= 10)
+			{
+				write(static_cast<char>('0' + fraction / divider));
+				fraction %= divider;
+			}
+		}
+
+		void flush()
+		{
+#if defined(LOGGERPP_CRASH_HANDLER_SUPPORTED)
+			std::size_t offset = 0;
+			while (offset < size)
+			{
+				const auto written = ::write(fd, buffer.data() + offset, size - offset);
+				if (written < 0 && errno == EINTR)
+					continue;
+				if (written <= 0)
+					break;
+				offset += static_cast<std::size_t>(written);
+			}
+#endif
+			size = 0;
+		}
+
+	private:
+		int fd;
+		std::array<char, 4096> buffer;
+		std::size_t size = 0;
+	};
+
+	inline void write_signal_safe(signal_safe_writer& out, const std::string& value)
+	{
+		out.write(value.data(), value.size());
+	}
+
+	inline void write_signal_safe(signal_safe_writer& out, const std::wstring& value)
+	{
+		for (const auto c : value)
+			out.write(c < 0x80 ? static_cast<char>(c) : '?');
+	}
+
+	template <typename value_t>
+	inline void write_signal_safe_value(signal_safe_writer& out, const value_t& value)
+	{
+		using type_t = std::decay_t<value_t>;
+		if constexpr (std::is_same_v<type_t, std::nullptr_t>)
+			out.write("(null)");
+		else if constexpr (std::is_same_v<type_t, utils::bool_t>)
+			out.write(value ? "true" : "false");
+		else if constexpr (std::is_same_v<type_t, std::int64_t>)
+			out.write_int(value);
+		else if constexpr (std::is_same_v<type_t, std::uint64_t>)
+			out.write_uint(value);
+		else if constexpr (std::is_same_v<type_t, double>)
+			out.write_double(value);
+		else if constexpr (std::is_same_v<type_t, std::string> || std::is_same_v<type_t, std::wstring>)
+			write_signal_safe(out, value);
+		else if constexpr (std::is_same_v<type_t, level>)
+		{
+			//utils::to_string allocates, so names are repeated here
+			static constexpr const char* names[] = {"unknown", "trace", "debug", "info", "warning", "error", "critical"};
+			const auto index = static_cast<std::size_t>(value);
+			out.write(index < std::size(names) ? names[index] : "undefined");
+		}
+		else if constexpr (std::is_same_v<type_t, std::chrono::system_clock::time_point>)
+			out.write_int(std::chrono::duration_cast<std::chrono::nanoseconds>(value.time_since_epoch()).count());
+		else if constexpr (std::is_integral_v<type_t> && std::is_signed_v<type_t>)
+			out.write_int(value);
+		else if constexpr (std::is_integral_v<type_t>)
+			out.write_uint(value);
+		else if constexpr (std::is_floating_point_v<type_t>)
+			out.write_double(value);
+		else
+			out.write("?");
+	}
+
+	template <typename variant_t>
+	inline void write_signal_safe_variant(signal_safe_writer& out, const variant_t& value)
+	{
+		if (value.valueless_by_exception())
+			return;
+		std::visit([&out] (const auto& v) {
+			write_signal_safe_value(out, v);
+		}, value);
+	}
+
+	//Message of LOGGERPP_LOG record is written as format with its arguments; the published table of sites is read without lock
+	template <typename tags_t>
+	inline void write_signal_safe_site_message(signal_safe_writer& out, const tags_t& tags, std::uint64_t id)
+	{
+		const auto site = sites().find(id);
+		if (site == nullptr)
+		{
+			out.write("unknown site ");
+			out.write_uint(id);
+			return;
+		}
+		auto arg = tags.end() - get_site_args_count(tags);
+		for (const char* format = site->format; *format != '\0'; ++format)
+		{
+			if (format[0] == '{' && format[1] == '}' && arg != tags.end())
+			{
+				write_signal_safe_variant(out, arg->value);
+				++arg;
+				++format;
+			}
+			else
+				out.write(*format);
+		}
+	}
+
+	//The layout of file_log_consumer, but time is written as nanoseconds since epoch: its usual text is made with allocations
+	template <typename traits_t>
+	inline void write_signal_safe_tags(signal_safe_writer& out, const typename traits_t::tags_t& tags)
+	{
+		const auto site_id = get_site_id(tags);
+		for (auto iter = traits_t::begin_guaratee_tag(tags); iter != traits_t::end_guaratee_tag(tags); ++iter)
+		{
+			if (iter != traits_t::begin_guaratee_tag(tags))
+				out.write('\t');
+			if (site_id != nullptr && static_cast<std::size_t>(iter - traits_t::begin_guaratee_tag(tags)) == constants::index_message)
+				write_signal_safe_site_message(out, tags, *site_id);
+			else
+				write_signal_safe_variant(out, iter->value);
+		}
+
+		//arguments of LOGGERPP_LOG are the part of message
+		for (auto iter = traits_t::begin_unguaratee_tag(tags); iter != traits_t::end_unguaratee_tag(tags) - get_site_args_count(tags); ++iter)
+		{
+			out.write('\t');
+			write_signal_safe_variant(out, iter->key);
+			out.write('=');
+			write_signal_safe_variant(out, iter->value);
+		}
+
+		//fields of schema are written as they are: conversion to value_t allocates
+		if constexpr (has_schema<typename traits_t::tags_t>::value)
+			for_each_field(tags.schema, [&out] (const char* key, const auto& value) {
+				out.write('\t');
+				out.write(key);
+				out.write('=');
+				write_signal_safe_value(out, value);
+			});
+		out.write('\n');
+	}
+
+	struct emergency_flush_entry
+	{
+		std::shared_ptr<void> dispatcher;
+		void (*drain)(void* dispatcher, int fd);
+		int fd;
+	};
+
+	//The signal handler counts itself in users while it uses the entry, so the entry is deleted after the handler leaves it
+	struct emergency_flush_slot
+	{
+		std::atomic<emergency_flush_entry*> entry {nullptr};
+		std::atomic<std::size_t> users {0};
+	};
+
+	static const std::size_t emergency_flush_entries_count = 16;
+
+	inline std::array<emergency_flush_slot, emergency_flush_entries_count>& get_emergency_flush_entries()
+	{
+		static std::array<emergency_flush_slot, emergency_flush_entries_count> entries {};
+		return entries;
+	}
+
+	template <typename traits_t>
+	inline void drain_signal_safe(void* ptr, int fd)
+	{
+		auto& disp = *static_cast<typename logger_base<traits_t>::dispatcher_t*>(ptr);
+		signal_safe_writer out(fd);
+		const auto visited = disp.visit_pending([&out] (const typename traits_t::tags_handle_t& tags_handle) {
+			try {
+				write_signal_safe_tags<traits_t>(out, traits_t::extract_tags(tags_handle));
+			} catch (...) {
+			}
+		});
+		if (!visited)
+			out.write("loggerpp: pending records are locked by crashed thread\n");
+	}
+
+#if defined(LOGGERPP_CRASH_HANDLER_SUPPORTED)
+	static constexpr int fatal_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+	//Actions of fatal signals before install_fatal_signal_handler; they are called after the flush
+	inline std::array<struct sigaction, std::size(fatal_signals)>& get_previous_actions()
+	{
+		static std::array<struct sigaction, std::size(fatal_signals)> actions {};
+		return actions;
+	}
+
+	inline void on_fatal_signal(int sig, siginfo_t* info, void* context)
+	{
+		//a fault inside of the flush must not flush again
+		static std::atomic_bool flushing {false};
+		if (!flushing.exchange(true))
+			for (auto& slot : get_emergency_flush_entries())
+			{
+				slot.users.fetch_add(1);
+				if (auto entry = slot.entry.load())
+					entry->drain(entry->dispatcher.get(), entry->fd);
+				slot.users.fetch_sub(1);
+			}
+
+		const auto iter = std::find(std::begin(fatal_signals), std::end(fatal_signals), sig);
+		const auto& previous = get_previous_actions()[static_cast<std::size_t>(iter - std::begin(fatal_signals))];
+		::sigaction(sig, &previous, nullptr);
+		if ((previous.sa_flags & SA_SIGINFO) != 0)
+			previous.sa_sigaction(sig, info, context);
+		else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN)
+			previous.sa_handler(sig);
+		else
+			::raise(sig);
+	}
+
+	inline void install_fatal_signal_handler()
+	{
+		static std::atomic_bool installed {false};
+		if (installed.exchange(true))
+			return;
+
+		struct sigaction action {};
+		action.sa_sigaction = on_fatal_signal;
+		action.sa_flags = SA_SIGINFO | SA_NODEFER;
+		sigemptyset(&action.sa_mask);
+		for (std::size_t index = 0; index < std::size(fatal_signals); ++index)
+			::sigaction(fatal_signals[index], &action, &get_previous_actions()[index]);
+	}
+#else
+	inline void install_fatal_signal_handler()
+	{}
+#endif
+}//namespace details
+
+	//Opt-in: on SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT the records still queued in the dispatcher
+	//are written to fd by raw write(2), then the handlers installed before are called. POSIX only; it does nothing elsewhere.
+	//Flushing is active while the returned handle is alive; returns nullptr if too many dispatchers are registered.
+	template <typename traits_t>
+	inline std::shared_ptr<void> enable_emergency_flush(const logger_base<traits_t>& ref, int fd)
+	{
+		details::install_fatal_signal_handler();
+
+		auto entry = new details::emergency_flush_entry{ref.get_dispatcher(), &details::drain_signal_safe<traits_t>, fd};
+		for (auto& slot : details::get_emergency_flush_entries())
+		{
+			details::emergency_flush_entry* expected = nullptr;
+			if (slot.entry.compare_exchange_strong(expected, entry))
+				return std::shared_ptr<void>(entry, [&slot] (void* ptr) {
+					//a fatal signal on another thread may have loaded the entry already
+					slot.entry.store(nullptr);
+					while (slot.users.load() != 0)
+						std::this_thread::yield();
+					delete static_cast<details::emergency_flush_entry*>(ptr);
+				});
+		}
+		delete entry;
+		return nullptr;
+	}
+} //namespace charivari_ltd::loggerpp
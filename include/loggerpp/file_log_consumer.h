@@ -34,15 +34,51 @@
 #pragma once
 
 #include "logger.h"
+#include "log_schema.h"
 
 #include <utils/utils.h>
 
 #include <fstream>
+#include <ostream>
 
 namespace charivari_ltd::loggerpp
 {
 namespace details
 {
+	struct text_context_format {};
+
+	//Text layout of a record: guaranteed tags are separated by tab, others are key=value.
+	//Context tags of logger are rendered once per logger, see context_cache.
+	template <typename traits_t>
+	inline void write_text_record(std::ostream& out, const typename traits_t::tags_t& tags, const context_cache* context = nullptr, const render_cache* cache = nullptr)
+	{
+		write_text_head<traits_t>(out, tags, cache);
+
+		//arguments of LOGGERPP_LOG are the part of message
+		const auto end = traits_t::end_unguaratee_tag(tags) - get_site_args_count(tags);
+		auto begin = traits_t::begin_unguaratee_tag(tags);
+		if (context != nullptr && context->count <= static_cast<std::size_t>(end - begin))
+		{
+			out << get_rendered<text_context_format>(context->cache, [begin, context] (std::ostream& text) {
+				for (auto iter = begin; iter != begin + context->count; ++iter)
+					text << '\t' << to_string(iter->key) << '=' << to_string(iter->value);
+			});
+			begin += context->count;
+		}
+		for (auto iter = begin; iter != end; ++iter)
+		{
+			out << '\t' << to_string(iter->key) << '=' << to_string(iter->value);
+		}
+
+		for_each_schema_tag<typename traits_t::value_t>(tags, [&out] (const char* key, const auto& value) {
+			out << '\t' << key << '=' << to_string(value);
+		});
+
+		out << '\n';
+	}
+
+	struct text_record_format {};
+
 	template <typename traits_t>
 	class file_log_consumer
 	{
@@ -54,22 +90,10 @@ namespace details
 	public:
 		void push(const typename traits_t::tags_handle_t& tags_handle)
 		{
-			const auto& tags = traits_t::extract_tags(tags_handle);
-
-			for (auto iter = traits_t::begin_guaratee_tag(tags); iter != traits_t::end_guaratee_tag(tags); ++iter)
-			{
-				if (iter != traits_t::begin_guaratee_tag(tags))
-					file << '\t';
-
-				file << to_string(iter->value);
-			}
-
-			for (auto iter = traits_t::begin_unguaratee_tag(tags); iter != traits_t::end_unguaratee_tag(tags); ++iter)
-			{
-				file << '\t' << to_string(iter->key) << '=' << to_string(iter->value);
-			}
-
-			file << std::endl;
+			write_rendered<traits_t, text_record_format>(file, tags_handle, [&tags_handle] (std::ostream& out) {
+				write_text_record<traits_t>(out, traits_t::extract_tags(tags_handle), get_context<traits_t>(tags_handle), get_render_cache<traits_t>(tags_handle));
+			});
+			file.flush();
 		}
 
 	private:
@@ -81,9 +105,9 @@ namespace details
 	inline auto build_base_file_log_consumer(const std::string& path)
 	{
 		auto consumer = std::make_shared<details::file_log_consumer<traits_t>>(path);
-		return [consumer] (const default_log_traits::tags_handle_t& tags_handle) {
+		return details::make_text_consumer([consumer] (const typename traits_t::tags_handle_t& tags_handle) {
 			consumer->push(tags_handle);
-		};
+		});
 	}
 
 	inline auto build_file_log_consumer(const std::string& path)
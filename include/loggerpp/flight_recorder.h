@@ -0,0 +1,249 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "logger.h"
+#include "log_schema.h"
+#include "binary_log_format.h"
+
+#include <utils/noncopyable.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace charivari_ltd::loggerpp
+{
+	struct flight_recorder_options
+	{
+		std::size_t max_records = 1024;
+		std::size_t max_bytes = 1 << 20;				//size of the preallocated ring
+		level pass_level = level::info;					//records of the level and above go to target at once, others go to the ring only
+		level trigger_level = level::error;				//records of the level and above dump the ring to target before them
+		std::chrono::milliseconds min_dump_interval {1000};
+	};
+
+	//Keeps recent low-level records in a preallocated ring and passes them to target as context of an error.
+	//Records are serialized into the ring, so storing needs no allocation once the scratch buffer fits the largest record
+	//(string fields of schema are still copied, see for_each_schema_tag).
+	//Consumers are called by one thread at a time, so the ring needs no locks.
+	template <typename traits_t>
+	class flight_recorder :
+		public utils::noncopyable
+	{
+	public:
+		using tags_t = typename traits_t::tags_t;
+		using tag_t = typename traits_t::tag_t;
+		using key_t = typename traits_t::key_t;
+		using value_t = typename traits_t::value_t;
+		using tags_handle_t = typename traits_t::tags_handle_t;
+		using consumer_fn = std::function<void (const tags_handle_t& tags)>;
+
+	public:
+		explicit flight_recorder(consumer_fn&& target, const flight_recorder_options& options = {}) :
+			target(std::move(target)),
+			options(options),
+			ring(options.max_bytes)
+		{
+			scratch.reserve(1024);
+		}
+
+	public:
+		void push(const tags_handle_t& tags_handle)
+		{
+			const auto& tags = traits_t::extract_tags(tags_handle);
+			const auto lvl = get_record_level(tags);
+			if (lvl < options.pass_level)
+				return store(tags);
+
+			if (lvl >= options.trigger_level)
+			{
+				const auto now = std::chrono::steady_clock::now();
+				if (!last_dump || now - *last_dump >= options.min_dump_interval)
+				{
+					last_dump = now;
+					dump();
+				}
+			}
+			target(tags_handle);
+		}
+
+		//Passes the ring to target from the oldest record and clears it; returns count of the records.
+		//A record leaves the ring before it's passed, so the rest stays in the ring if target throws.
+		std::size_t dump()
+		{
+			const auto dumped = count;
+			while (count != 0)
+			{
+				const auto size = read_size(head);
+				scratch.resize(size);
+				copy_out(advance(head, sizeof(std::uint32_t)), scratch.data(), size);
+				evict();
+				target(traits_t::make_tags_handle(decode(scratch)));
+			}
+			head = tail = used = 0;
+			return dumped;
+		}
+
+		std::size_t get_records_count() const
+		{
+			return count;
+		}
+
+	private:
+		static level get_record_level(const tags_t& tags)
+		{
+			if (tags.size() > constants::index_level)
+				if (const auto lvl = std::get_if<level>(&tags[constants::index_level].value))
+					return *lvl;
+			return level::unknown;
+		}
+
+		void store(const tags_t& tags)
+		{
+			scratch.clear();
+			details::binary_log::buffer_writer out(scratch);
+			out.put(static_cast<std::uint32_t>(tags.size()));
+			for (const auto& tag : tags)
+			{
+				out.put_value(tag.key);
+				out.put_value(tag.value);
+			}
+			out.put(static_cast<std::uint32_t>(details::get_schema_tags_count<tags_t>()));
+			details::for_each_schema_tag<value_t>(tags, [&out] (const char* key, const auto& value) {
+				out.put_string(key);
+				out.put_value(value);
+			});
+
+			const auto size = sizeof(std::uint32_t) + scratch.size();
+			if (size > ring.size() || options.max_records == 0)
+				return;
+			while (count != 0 && (count >= options.max_records || ring.size() - used < size))
+				evict();
+
+			const auto length = static_cast<std::uint32_t>(scratch.size());
+			copy_in(tail, reinterpret_cast<const char*>(&length), sizeof(length));
+			copy_in(advance(tail, sizeof(length)), scratch.data(), scratch.size());
+			tail = advance(tail, size);
+			used += size;
+			++count;
+		}
+
+		void evict()
+		{
+			const auto size = sizeof(std::uint32_t) + read_size(head);
+			head = advance(head, size);
+			used -= size;
+			--count;
+		}
+
+		tags_t decode(const std::string& data) const
+		{
+			details::binary_log::buffer_reader reader(data.data(), data.size());
+			tags_t tags;
+			const auto size = reader.get_count(2 * sizeof(details::binary_log::value_type));
+			for (std::uint32_t index = 0; index < size; ++index)
+			{
+				auto key = reader.get_value<key_t>();
+				tags.push_back(tag_t{std::move(key), reader.get_value<value_t>()});
+			}
+			const auto fields = reader.get_count(sizeof(std::uint32_t) + sizeof(details::binary_log::value_type));
+			for (std::uint32_t index = 0; index < fields; ++index)
+			{
+				const auto key = reader.get_string();
+				details::set_schema_tag(tags, key, reader.get_value<value_t>());
+			}
+			return tags;
+		}
+
+		std::uint32_t read_size(std::size_t position) const
+		{
+			std::uint32_t size = 0;
+			copy_out(position, reinterpret_cast<char*>(&size), sizeof(size));
+			return size;
+		}
+
+		std::size_t advance(std::size_t position, std::size_t size) const
+		{
+			return (position + size) % ring.size();
+		}
+
+		void copy_in(std::size_t position, const char* data, std::size_t size)
+		{
+			const auto first = std::min(size, ring.size() - position);
+			std::memcpy(ring.data() + position, data, first);
+			std::memcpy(ring.data(), data + first, size - first);
+		}
+
+		void copy_out(std::size_t position, char* data, std::size_t size) const
+		{
+			const auto first = std::min(size, ring.size() - position);
+			std::memcpy(data, ring.data() + position, first);
+			std::memcpy(data + first, ring.data(), size - first);
+		}
+
+	private:
+		consumer_fn target;
+		const flight_recorder_options options;
+		std::optional<std::chrono::steady_clock::time_point> last_dump;
+
+		std::vector<char> ring;
+		std::size_t head = 0;	//the oldest record
+		std::size_t tail = 0;	//the next record
+		std::size_t used = 0;
+		std::size_t count = 0;
+		std::string scratch;
+	};
+
+	template <typename traits_t>
+	inline auto build_base_flight_recorder(typename flight_recorder<traits_t>::consumer_fn&& target, const flight_recorder_options& options = {})
+	{
+		auto recorder = std::make_shared<flight_recorder<traits_t>>(std::move(target), options);
+		return [recorder] (const typename traits_t::tags_handle_t& tags_handle) {
+			recorder->push(tags_handle);
+		};
+	}
+
+	//root >> build_flight_recorder(build_file_log_consumer("app.log"));
+	inline auto build_flight_recorder(flight_recorder<default_log_traits>::consumer_fn&& target, const flight_recorder_options& options = {})
+	{
+		return build_base_flight_recorder<default_log_traits>(std::move(target), options);
+	}
+} //namespace charivari_ltd::loggerpp
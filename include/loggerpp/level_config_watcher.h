@@ -0,0 +1,199 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "log_registry.h"
+#include "log_thread.h"
+
+#include <utils/noncopyable.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if defined(__linux__)
+#include <limits.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace charivari_ltd::loggerpp
+{
+	inline void load_levels(level_registry& registry, const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			throw std::runtime_error("can't open " + path);
+		registry.load(file);
+	}
+
+	//Loads levels of named loggers from file and reloads them when the file is changed.
+	//The changes are tracked by inotify on Linux; other platforms load the file once for now.
+	class level_config_watcher :
+		public utils::noncopyable
+	{
+	public:
+		using exception_handler_t = std::function<void (std::exception_ptr)>;
+
+	public:
+		//Throws if the file can't be loaded initially; later errors are passed to handler and keep the current levels
+		explicit level_config_watcher(const std::string& path, level_registry& registry = levels(), exception_handler_t&& handler = [] (std::exception_ptr) {}, const thread_options& options = {}) :
+			path(path),
+			registry(registry),
+			exception_handler(std::move(handler))
+		{
+			load_levels(registry, path);
+#if defined(__linux__)
+			const auto separator = path.rfind('/');
+			const auto directory = separator == std::string::npos ? std::string{"."} : path.substr(0, separator + 1);
+			file_name = separator == std::string::npos ? path : path.substr(separator + 1);
+
+			//editors replace the file instead of writing, so the directory is watched
+			notify_fd = ::inotify_init1(IN_CLOEXEC);
+			if (notify_fd < 0)
+				throw std::system_error(errno, std::generic_category(), "inotify_init1");
+			stop_fd = ::eventfd(0, EFD_CLOEXEC);
+			if (stop_fd < 0 || ::inotify_add_watch(notify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+			{
+				const auto error = errno;
+				close();
+				throw std::system_error(error, std::generic_category(), "inotify_add_watch");
+			}
+
+			thread = std::thread([this, options] {
+				try {
+					apply_thread_options(options);
+				} catch (...) {
+					exception_handler(std::current_exception());
+				}
+				run();
+			});
+#else
+			(void)options;
+#endif
+		}
+
+		~level_config_watcher()
+		{
+#if defined(__linux__)
+			const std::uint64_t value = 1;
+			while (::write(stop_fd, &value, sizeof(value)) < 0 && errno == EINTR)
+				;
+			thread.join();
+			close();
+#endif
+		}
+
+	private:
+#if defined(__linux__)
+		void run()
+		{
+			alignas(inotify_event) char buffer[sizeof(inotify_event) + NAME_MAX + 1];
+			pollfd fds[2] = {{notify_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+			int backoff_ms = min_backoff_ms;
+			for (;;)
+			{
+				//only stop_fd ends watching; a failed poll is reported and retried after a growing pause
+				if (::poll(fds, 2, -1) < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					exception_handler(std::make_exception_ptr(std::system_error(errno, std::generic_category(), "poll")));
+					if (::poll(&fds[1], 1, backoff_ms) > 0 && fds[1].revents != 0)
+						return;
+					backoff_ms = std::min(backoff_ms * 2, max_backoff_ms);
+					continue;
+				}
+				backoff_ms = min_backoff_ms;
+				if (fds[1].revents != 0)
+					return;
+
+				const auto size = ::read(notify_fd, buffer, sizeof(buffer));
+				if (size <= 0)
+					continue;
+				bool changed = false;
+				for (auto ptr = buffer; ptr < buffer + size; )
+				{
+					const auto event = reinterpret_cast<const inotify_event*>(ptr);
+					if (event->len != 0 && file_name == event->name)
+						changed = true;
+					ptr += sizeof(inotify_event) + event->len;
+				}
+				if (changed)
+					reload();
+			}
+		}
+
+		void reload()
+		{
+			try {
+				load_levels(registry, path);
+			} catch (...) {
+				exception_handler(std::current_exception());
+			}
+		}
+
+		void close()
+		{
+			if (notify_fd >= 0)
+				::close(notify_fd);
+			if (stop_fd >= 0)
+				::close(stop_fd);
+		}
+#endif
+
+	private:
+		const std::string path;
+		level_registry& registry;
+		exception_handler_t exception_handler;
+#if defined(__linux__)
+		static constexpr int min_backoff_ms = 10;
+		static constexpr int max_backoff_ms = 1000;
+
+		std::string file_name;
+		int notify_fd = -1;
+		int stop_fd = -1;
+		std::thread thread;
+#endif
+	};
+} //namespace charivari_ltd::loggerpp
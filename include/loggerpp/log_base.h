@@ -35,6 +35,11 @@
 
 #include "log_level.h"
 #include "log_dispatcher.h"
+#include "log_formatter.h"
+#include "log_registry.h"
+#include "log_site.h"
+#include "log_stream.h"
+#include "log_render_cache.h"
 
 #include <utils/noncopyable.h>
 
@@ -57,6 +62,8 @@ namespace charivari_ltd::loggerpp
 		static constexpr const char key_time[] = "time";
 		static constexpr const char key_level[] = "level";
 		static constexpr const char key_message[] = "message";
+		static constexpr const char key_site[] = "site";		//replaces "message" in records of LOGGERPP_LOG; the value is site id
+		static constexpr const char key_logger[] = "logger";
 		static constexpr const char key_exception_type[] = "exception_type";
 		static constexpr const char key_exception_message[] = "exception_message";
 	} //namespace constants
@@ -74,8 +81,9 @@ namespace charivari_ltd::loggerpp
 		using tags_t = typename traits_t::tags_t;
 		using tags_handle_t = typename traits_t::tags_handle_t;
 		using formatter_t = typename traits_t::formatter_t;
+		using metrics_t = typename traits_t::metrics_t;
 
-		using dispatcher_t = dispatcher<tags_handle_t>;
+		using dispatcher_t = dispatcher<tags_handle_t, metrics_t>;
 		using dispatcher_ptr = std::shared_ptr<dispatcher_t>;
 
 	public:
@@ -103,12 +111,17 @@ namespace charivari_ltd::loggerpp
 	public:
 
 		logger_base() :
-			logger_base(std::make_shared<dispatcher_t>(), {})
+			logger_base(std::make_shared<dispatcher_t>(traits_t::get_dispatcher_options()), {})
 		{}
 
 		logger_base(const dispatcher_ptr& disp, tags_t&& tags) :
+			logger_base(disp, std::move(tags), details::any_level())
+		{}
+
+		logger_base(const dispatcher_ptr& disp, tags_t&& tags, const level_ptr& threshold) :
 			disp(disp),
-			tags(std::move(tags))
+			tags(std::move(tags)),
+			threshold(threshold)
 		{}
 
 	public:
@@ -122,22 +135,42 @@ namespace charivari_ltd::loggerpp
 			return tags;
 		}
 
+		const level_ptr& get_threshold() const
+		{
+			return threshold;
+		}
+
+		bool is_enabled(const level& lvl) const
+		{
+			return lvl >= threshold->load(std::memory_order_relaxed);
+		}
+
 	public:
 		template <typename string_t>
 		void log(tags_t&& add_tags, const level& lvl, string_t&& message) const
 		{
+			if (!is_enabled(lvl))
+				return;
+			if (!disp->is_started())
+				return disp->discard();
 			auto&& t = extend_front(tags, {
 				{constants::key_message, std::move(message)},
 				{constants::key_level, lvl},
 				{constants::key_time, std::chrono::system_clock::now()},
 			});
 			t = extend_back(std::move(t), std::move(add_tags));
-			disp->push(traits_t::make_tags_handle(std::move(t)));
+			auto tags_handle = details::make_tags_handle<traits_t>(std::move(t), context.template get<traits_t>(tags), disp->is_render_shared());
+			details::serialize_on_producer<traits_t>(tags_handle);
+			disp->push(lvl, std::move(tags_handle));
 		}
 
 		template <typename string_t, typename ... args_t>
 		void log(const level& lvl, tags_t&& add_tags, string_t&& format, args_t&& ... args) const
 		{
+			if (!is_enabled(lvl))
+				return;
+			if (!disp->is_started())
+				return disp->discard();
 			auto&& message = formatter_t::format(std::move(format), std::forward<args_t>(args)...);
 			return log(std::move(add_tags), lvl, std::move(message));
 		}
@@ -152,6 +185,29 @@ namespace charivari_ltd::loggerpp
 			return log(lvl, std::move(add_tags), std::wstring(message), std::forward<args_t>(args)...);
 		}
 
+		//Used by LOGGERPP_LOG: the message is replaced by "site" tag with site id, the arguments are appended as tags "0", "1", ...
+		template <typename ... args_t>
+		void log(log_site& site, const char*, args_t&& ... args) const
+		{
+			if (!is_enabled(site.lvl))
+				return;
+			if (!disp->is_started())
+				return disp->discard();
+
+			auto&& t = extend_front(tags, {
+				{constants::key_site, site.id},
+				{constants::key_level, site.lvl},
+				{constants::key_time, std::chrono::system_clock::now()},
+			});
+			const auto& keys = details::get_site_arg_keys<sizeof...(args_t)>();
+			tags_t site_args;
+			(site_args.push_back(tag_t{keys[site_args.size()], to_site_value(std::forward<args_t>(args))}), ...);
+			t = extend_back(std::move(t), std::move(site_args));
+			auto tags_handle = details::make_tags_handle<traits_t>(std::move(t), context.template get<traits_t>(tags), disp->is_render_shared());
+			details::serialize_on_producer<traits_t>(tags_handle);
+			disp->push(site.lvl, std::move(tags_handle));
+		}
+
 		template <typename string_t, typename ... args_t>
 		void log(const level& lvl, string_t&& format, args_t&& ... args) const
 		{
@@ -168,6 +224,28 @@ namespace charivari_ltd::loggerpp
 			return log(lvl, std::wstring(message), std::forward<args_t>(args)...);
 		}
 
+	public:
+		//Returns stream which logs the collected message at the end of statement
+		record_stream<logger_base> stream(const level& lvl) const
+		{
+			if (!is_enabled(lvl))
+				return {nullptr, lvl};
+			if (!disp->is_started())
+			{
+				disp->discard();
+				return {nullptr, lvl};
+			}
+			return {this, lvl};
+		}
+
+		record_stream<logger_base> unknown() const { return stream(level::unknown); }
+		record_stream<logger_base> trace() const { return stream(level::trace); }
+		record_stream<logger_base> debug() const { return stream(level::debug); }
+		record_stream<logger_base> info() const { return stream(level::info); }
+		record_stream<logger_base> warning() const { return stream(level::warning); }
+		record_stream<logger_base> error() const { return stream(level::error); }
+		record_stream<logger_base> critical() const { return stream(level::critical); }
+
 	public:
 		template <typename ... args_t>
 		void unknown(args_t&& ... args) const
@@ -211,16 +289,47 @@ namespace charivari_ltd::loggerpp
 			log(level::critical, std::forward<args_t>(args)...);
 		}
 
+	private:
+		template <typename arg_t>
+		static value_t to_site_value(arg_t&& arg)
+		{
+			using type_t = std::decay_t<arg_t>;
+			if constexpr (details::is_lazy_arg<type_t>::value)
+				return to_site_value(arg());
+			else if constexpr (std::is_integral_v<type_t> && !std::is_same_v<type_t, bool> && std::is_signed_v<type_t> && std::is_constructible_v<value_t, std::int64_t>)
+				return static_cast<std::int64_t>(arg);
+			else if constexpr (std::is_integral_v<type_t> && !std::is_same_v<type_t, bool> && std::is_constructible_v<value_t, std::uint64_t>)
+				return static_cast<std::uint64_t>(arg);
+			else if constexpr (std::is_floating_point_v<type_t> && std::is_constructible_v<value_t, double>)
+				return static_cast<double>(arg);
+			else if constexpr (std::is_convertible_v<arg_t, std::string> && std::is_constructible_v<value_t, std::string>)
+				return std::string(std::forward<arg_t>(arg));
+			else if constexpr (std::is_convertible_v<arg_t, std::wstring> && std::is_constructible_v<value_t, std::wstring>)
+				return std::wstring(std::forward<arg_t>(arg));
+			else
+				return utils::to_string(arg);
+		}
+
 	private:
 		dispatcher_ptr disp;
 		tags_t tags;
+		level_ptr threshold;
+		details::lazy_context context;
 	};
 
 	template <typename traits_t>
 	inline logger_base<traits_t> extend_logger(const logger_base<traits_t>& ref, typename traits_t::tags_t&& tags)
 	{
 		using logger_t = logger_base<traits_t>;
-		return {ref.get_dispatcher(), logger_t::extend_back(ref.get_tags(), std::move(tags))};
+		return {ref.get_dispatcher(), logger_t::extend_back(ref.get_tags(), std::move(tags)), ref.get_threshold()};
+	}
+
+	//Named logger: the name is added as "logger" tag, the level is controlled by registry
+	template <typename traits_t>
+	inline logger_base<traits_t> get_logger(const logger_base<traits_t>& ref, const std::string& name, level_registry& registry = levels())
+	{
+		using logger_t = logger_base<traits_t>;
+		return {ref.get_dispatcher(), logger_t::extend_back(ref.get_tags(), {{constants::key_logger, name}}), registry.get_level(name)};
 	}
 
 	template <typename traits_t, typename exception_t>
@@ -238,6 +347,18 @@ namespace charivari_ltd::loggerpp
 		return ref.get_dispatcher()->subscribe(std::move(consumer));
 	}
 
+	template <typename traits_t, typename consumer_t>
+	inline auto operator >> (const logger_base<traits_t>& ref, details::text_consumer<consumer_t> consumer)
+	{
+		return ref.get_dispatcher()->subscribe(std::move(consumer));
+	}
+
+	template <typename traits_t, typename consumer_t>
+	inline auto operator >> (const logger_base<traits_t>& ref, details::flushable_consumer<consumer_t> consumer)
+	{
+		return ref.get_dispatcher()->subscribe(std::move(consumer));
+	}
+
 	template <typename traits_t>
 	inline auto operator | (const logger_base<traits_t>& ref, typename traits_t::tag_t&& tag)
 	{
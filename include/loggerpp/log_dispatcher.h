@@ -33,22 +33,197 @@
 
 #pragma once
 
-#include <utils/task_queue.h>
+#include "log_level.h"
+#include "log_metrics.h"
+#include "log_render_cache.h"
+#include "log_worker.h"
+
 #include <utils/noncopyable.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <future>
-#include <set>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace charivari_ltd::loggerpp
 {
-	template <typename tags_handle_t>
+	enum class ordering
+	{
+		relaxed,	//records of higher levels may overtake records of lower levels
+		strict,		//records are passed to consumer in order of push
+	};
+
+	enum class dispatch_mode
+	{
+		asynchronous,	//consumers are called on the dispatcher thread
+		synchronous,	//consumers are called on the thread which logs; no dispatcher thread at all
+	};
+
+	struct dispatcher_options
+	{
+		dispatch_mode mode = dispatch_mode::asynchronous;
+		worker_options worker;
+		bool shared_worker = false;		//use the process-wide worker instead of own thread; worker options are ignored
+	};
+
+	namespace details
+	{
+		enum class lane : std::size_t
+		{
+			high,		//critical, error
+			normal,		//warning, info
+			low,		//debug, trace, unknown
+		};
+
+		static const std::size_t lanes_count = 3;
+		static const std::size_t drain_batch_size = 64;
+		static const std::size_t drain_batches_per_task = 16;
+		//A waiting lane is served after so many batches of higher lanes, so a steady stream of errors doesn't starve debug records
+		//(and the records which strict subscriptions hold behind them)
+		static const std::size_t lane_quota = 8;
+
+		inline lane get_lane(const level& lvl)
+		{
+			switch (lvl)
+			{
+				case level::critical:
+				case level::error:
+					return lane::high;
+				case level::warning:
+				case level::info:
+					return lane::normal;
+				default:
+					return lane::low;
+			}
+		}
+
+		//Spin lock over atomic flag: it's taken by the changes of lanes (under lanes_mutex too)
+		//and tried by visit_pending, which can't lock mutexes in a signal handler
+		class lanes_change
+		{
+		public:
+			explicit lanes_change(std::atomic_flag& flag) :
+				flag(flag),
+				owns(true)
+			{
+				while (flag.test_and_set(std::memory_order_acquire))
+					std::this_thread::yield();
+			}
+
+			lanes_change(std::atomic_flag& flag, std::try_to_lock_t) :
+				flag(flag),
+				owns(!flag.test_and_set(std::memory_order_acquire))
+			{}
+
+			lanes_change(const lanes_change&) = delete;
+			lanes_change& operator = (const lanes_change&) = delete;
+
+			~lanes_change()
+			{
+				if (owns)
+					flag.clear(std::memory_order_release);
+			}
+
+			bool owns_lock() const
+			{
+				return owns;
+			}
+
+		private:
+			std::atomic_flag& flag;
+			const bool owns;
+		};
+
+		using deadline_flush_fn = std::function<bool (const std::chrono::steady_clock::time_point& deadline)>;
+		using stop_fn = std::function<std::size_t ()>;
+
+		template <typename flush_t>
+		inline deadline_flush_fn make_deadline_flush(flush_t&& flush)
+		{
+			if constexpr (std::is_invocable_v<flush_t, const std::chrono::steady_clock::time_point&>)
+				return std::forward<flush_t>(flush);
+			else
+				return [flush = std::forward<flush_t>(flush)] (const std::chrono::steady_clock::time_point&) {
+					flush();
+					return true;
+				};
+		}
+
+		//Consumer with functions which are called on the dispatcher thread:
+		//flush by dispatcher::flush and dispatcher::shutdown, e.g. to write the data which sink buffers in memory,
+		//it returns false if deadline is reached first; stop by dispatcher::shutdown for a consumer with own queue
+		//(see run_own_thread), it returns count of the records which are not passed.
+		template <typename consumer_t>
+		struct flushable_consumer
+		{
+			consumer_t consumer;
+			deadline_flush_fn flush;
+			stop_fn stop;
+		};
+
+		//flush is either void () or bool (deadline)
+		template <typename consumer_t, typename flush_t>
+		inline auto make_flushable_consumer(consumer_t&& consumer, flush_t&& flush, stop_fn&& stop = {})
+		{
+			return flushable_consumer<std::decay_t<consumer_t>>{std::forward<consumer_t>(consumer), make_deadline_flush(std::forward<flush_t>(flush)), std::move(stop)};
+		}
+	}//namespace details
+
+	template <typename tags_handle_t, typename metrics_t = no_metrics>
 	class dispatcher :
+		public std::enable_shared_from_this<dispatcher<tags_handle_t, metrics_t>>,
 		public utils::noncopyable
 	{
 	public:
 		using consumer_fn = std::function<void (const tags_handle_t& tags)>;
-		using exception_handler_t = utils::task_queue::exception_handler_t;
+		using flush_fn = std::function<void ()>;
+		using exception_handler_t = worker::exception_handler_t;
+		using time_point_t = std::chrono::steady_clock::time_point;
+
+	private:
+		struct record :
+			metrics_t::stamp_t
+		{
+			std::uint64_t sequence;
+			tags_handle_t tags;
+		};
+
+		//A record which overtook the previous ones is moved here once for all strict subscriptions
+		using record_ptr = std::shared_ptr<const record>;
+
+		struct later_record
+		{
+			bool operator () (const record_ptr& l, const record_ptr& r) const
+			{
+				return l->sequence > r->sequence;
+			}
+		};
+
+		struct subscription
+		{
+			details::deadline_flush_fn flush;
+			details::stop_fn stop;
+			ordering order;
+			std::uint64_t first;	//records pushed before subscribe are not passed to consumer
+			std::uint64_t next;		//used for ordering::strict only
+			std::priority_queue<record_ptr, std::vector<record_ptr>, later_record> pending;
+			typename metrics_t::consumer_stats_ptr stats;
+			bool removed = false;	//unsubscribed by a consumer of synchronous dispatcher; it's erased after the record is passed
+		};
 
 	public:
 		dispatcher() :
@@ -57,67 +232,749 @@ namespace charivari_ltd::loggerpp
 			})
 		{}
 
-		explicit dispatcher(exception_handler_t&& handler) :
+		explicit dispatcher(const dispatcher_options& options) :
+			dispatcher(get_default_exception_handler(options.mode), options)
+		{}
+
+		//The dispatcher thread is started by the first subscribe
+		explicit dispatcher(exception_handler_t&& handler, const dispatcher_options& options = {}) :
 			exception_handler(std::move(handler)),
-			queue([this] (std::exception_ptr ptr) {
-				handle(ptr);
-			})
+			options(options)
 		{}
 
-		auto subscribe(consumer_fn&& consumer)
+		//Tasks of the worker refer to the dispatcher: own worker is joined here while the members are alive,
+		//and a shared worker outlives the dispatcher, so the tasks which refer to it are waited.
+		//Released by a task of the shared worker (e.g. a consumer drops the last logger) the dispatcher can't wait for the worker:
+		//the queued records are passed here and the later tasks of the dispatcher are skipped.
+		//A task of the dispatcher itself keeps it alive, so such destruction is deferred to the end of the task.
+		~dispatcher()
 		{
-			auto ptr = std::shared_ptr<consumer_fn>(new consumer_fn{std::move(consumer)}, [this](consumer_fn* ptr) {
-				unsubscribe(ptr);
-				delete ptr;
+			if (queue == nullptr)
+				return;
+			if (!options.shared_worker)
+			{
+				queue->stop();
+				queue.reset();
+				return;
+			}
+			if (queue->is_current())
+			{
+				while (take_batch())
+					dispatch_batch();
+				*alive = false;
+				return;
+			}
+			std::unique_lock<std::mutex> lock(lanes_mutex);
+			flushed.wait(lock, [this] {
+				return posted == 0;
 			});
+		}
 
-			queue.push([this, ptr = ptr.get()] {
-				consumers.insert(ptr);
-			});
-			return ptr;
+		auto subscribe(consumer_fn&& consumer, ordering order = ordering::relaxed)
+		{
+			return subscribe(std::move(consumer), {}, {}, order, false);
+		}
+
+		//flush is called on the dispatcher thread by dispatcher::flush
+		auto subscribe(consumer_fn&& consumer, flush_fn&& flush, ordering order = ordering::relaxed)
+		{
+			return subscribe(std::move(consumer), to_deadline_flush(std::move(flush)), {}, order, false);
+		}
+
+		template <typename consumer_t>
+		auto subscribe(details::text_consumer<consumer_t> consumer, ordering order = ordering::relaxed)
+		{
+			return subscribe(consumer_fn{std::move(consumer)}, {}, {}, order, true);
+		}
+
+		template <typename consumer_t>
+		auto subscribe(details::text_consumer<consumer_t> consumer, flush_fn&& flush, ordering order = ordering::relaxed)
+		{
+			return subscribe(consumer_fn{std::move(consumer)}, to_deadline_flush(std::move(flush)), {}, order, true);
+		}
+
+		template <typename consumer_t>
+		auto subscribe(details::flushable_consumer<consumer_t> consumer, ordering order = ordering::relaxed)
+		{
+			return subscribe(consumer_fn{std::move(consumer.consumer)}, std::move(consumer.flush), std::move(consumer.stop), order, details::is_text_consumer<consumer_t>::value);
 		}
 
 		void push(tags_handle_t&& tags)
 		{
-			queue.push([this, tags{std::move(tags)}] {
-				dispatch(tags);
+			push(level::info, std::move(tags));
+		}
+
+		void push(const level& lvl, tags_handle_t&& tags)
+		{
+			if (!is_started())
+				return metrics.on_undelivered(1);
+			if (options.mode == dispatch_mode::synchronous)
+				return push_inline(std::move(tags));
+
+			bool schedule = false;
+			{
+				std::lock_guard<std::mutex> lock(lanes_mutex);
+				if (stopped)
+					return metrics.on_drop(1);
+				auto& lane = lanes[static_cast<std::size_t>(details::get_lane(lvl))];
+				details::lanes_change change(lanes_changing);
+				lane.push_back(record{metrics.on_push(), next_sequence++, std::move(tags)});
+				schedule = !drain_scheduled;
+				drain_scheduled = true;
+			}
+			if (schedule)
+				schedule_drain();
+		}
+
+		//Returns true when all the records pushed before the call are passed to consumers
+		//and flush functions of consumers are finished; false if deadline is reached first.
+		//Called by a consumer of asynchronous dispatcher it returns false at once: the records can't be passed while it waits.
+		bool flush(const time_point_t& deadline)
+		{
+			if (!is_started())
+				return true;
+			if (options.mode == dispatch_mode::synchronous)
+				return flush_consumers(get_inline_consumer_functions(), deadline);
+			if (queue->is_current())
+				return false;
+
+			{
+				std::unique_lock<std::mutex> lock(lanes_mutex);
+				const auto target = next_sequence;
+				++flush_waiters;
+				const auto dispatched = flushed.wait_until(lock, deadline, [this, target] {
+					return is_dispatched_before(target);
+				});
+				--flush_waiters;
+				if (!dispatched)
+					return false;
+			}
+
+			auto promise = std::make_shared<std::promise<bool>>();
+			auto future = promise->get_future();
+			post([this, promise, deadline] {
+				consumers.merge(get_pending_consumers());
+				promise->set_value(flush_consumers(get_consumer_functions(), deadline));
+			});
+			return future.wait_until(deadline) == std::future_status::ready && future.get();
+		}
+
+		template <typename rep_t, typename period_t>
+		bool flush(const std::chrono::duration<rep_t, period_t>& timeout)
+		{
+			return flush(std::chrono::steady_clock::now() + timeout);
+		}
+
+		//Stops accepting records and passes queued ones to consumers until deadline.
+		//Consumers are not called after return: the batch being dispatched at deadline is waited, own dispatcher thread is joined,
+		//and the queues of consumers (see run_own_thread, run_in_pool) are stopped.
+		//Later flush and unsubscribe are done on the calling thread.
+		//Returns count of the records which are dropped, including the ones left in the queues of consumers;
+		//called by a consumer it doesn't count the records held by strict subscriptions and queued by consumers.
+		std::size_t shutdown(const time_point_t& deadline)
+		{
+			{
+				std::lock_guard<std::mutex> lock(lanes_mutex);
+				stopped = true;
+			}
+			if (!is_started())
+				return 0;
+			if (options.mode == dispatch_mode::synchronous)
+			{
+				const auto functions = get_inline_consumer_functions();
+				flush_consumers(functions, deadline);
+				return stop_consumers(functions);
+			}
+
+			flush(deadline);
+
+			std::size_t dropped = 0;
+			{
+				std::lock_guard<std::mutex> lock(lanes_mutex);
+				details::lanes_change change(lanes_changing);
+				for (auto& lane : lanes)
+				{
+					dropped += lane.size();
+					lane.clear();
+				}
+			}
+			metrics.on_drop_queued(dropped);
+
+			//records held by strict subscriptions wait for the dropped ones, so they are dropped too
+			//after the batch being dispatched; the lanes are empty, so the task follows this batch only
+			auto promise = std::make_shared<std::promise<std::size_t>>();
+			auto future = promise->get_future();
+			post([this, promise] {
+				std::size_t count = 0;
+				{
+					std::lock_guard<std::mutex> lock(lanes_mutex);
+					count = held.size();
+				}
+				for (auto& [c, s] : consumers)
+					release_pending(s);
+				metrics.on_drop(count);
+				promise->set_value(count + stop_consumers(get_consumer_functions()));
 			});
+			if (queue->is_current())
+				return dropped;
+			dropped += future.get();
+			if (!options.shared_worker)
+				queue->join();
+			return dropped;
+		}
+
+		template <typename rep_t, typename period_t>
+		std::size_t shutdown(const std::chrono::duration<rep_t, period_t>& timeout)
+		{
+			return shutdown(std::chrono::steady_clock::now() + timeout);
+		}
+
+		//For crash handlers: visits not dispatched records without blocking and allocations.
+		//The current batch of the dispatcher thread goes first, next the queued records in order of push.
+		//Returns false if the records are being changed by another thread.
+		template <typename visitor_t>
+		bool visit_pending(visitor_t&& visitor)
+		{
+			details::lanes_change change(lanes_changing, std::try_to_lock);
+			if (!change.owns_lock())
+				return false;
+
+			//the record which is being dispatched right now is visited too
+			for (auto position = in_flight_position.load(std::memory_order_relaxed); position < in_flight.size(); ++position)
+				visitor(in_flight[position].tags);
+
+			std::array<typename std::deque<record>::const_iterator, details::lanes_count> iters;
+			for (std::size_t index = 0; index < details::lanes_count; ++index)
+				iters[index] = lanes[index].cbegin();
+
+			for (;;)
+			{
+				std::size_t next = details::lanes_count;
+				for (std::size_t index = 0; index < details::lanes_count; ++index)
+					if (iters[index] != lanes[index].cend() && (next == details::lanes_count || iters[index]->sequence < iters[next]->sequence))
+						next = index;
+				if (next == details::lanes_count)
+					return true;
+				visitor(iters[next]->tags);
+				++iters[next];
+			}
+		}
+
+		//True if several text consumers are subscribed, so records are worth a render cache
+		bool is_render_shared() const
+		{
+			return text_consumers.load(std::memory_order_relaxed) > 1;
+		}
+
+		//False until the first subscribe; records logged before are discarded without formatting
+		bool is_started() const
+		{
+			return started.load(std::memory_order_acquire);
+		}
+
+		//Counts a record which is discarded by logger before push
+		void discard()
+		{
+			metrics.on_undelivered(1);
+		}
+
+		//Always empty for no_metrics
+		metrics_snapshot get_metrics() const
+		{
+			return metrics.get_snapshot();
 		}
 
 	private:
-		void unsubscribe(consumer_fn* ptr)
+		static details::deadline_flush_fn to_deadline_flush(flush_fn&& flush)
+		{
+			if (!flush)
+				return {};
+			return details::make_deadline_flush(std::move(flush));
+		}
+
+		auto subscribe(consumer_fn&& consumer, details::deadline_flush_fn&& flush, details::stop_fn&& stop, ordering order, bool text)
 		{
+			auto ptr = std::shared_ptr<consumer_fn>(new consumer_fn{std::move(consumer)}, [this, text](consumer_fn* ptr) {
+				unsubscribe(std::unique_ptr<consumer_fn>(ptr));
+				if (text)
+					text_consumers.fetch_sub(1, std::memory_order_relaxed);
+			});
+			if (text)
+				text_consumers.fetch_add(1, std::memory_order_relaxed);
+			if (options.mode == dispatch_mode::synchronous)
+			{
+				std::lock_guard<std::recursive_mutex> lock(inline_mutex);
+				consumers.emplace(ptr.get(), subscription{std::move(flush), std::move(stop), order, next_sequence, next_sequence, {}, metrics.add_consumer()});
+				started.store(true, std::memory_order_release);
+				return ptr;
+			}
+
+			std::lock_guard<std::mutex> lock(lanes_mutex);
+			if (queue == nullptr)
+				start();
+			pending_consumers.emplace(ptr.get(), subscription{std::move(flush), std::move(stop), order, next_sequence, next_sequence, {}, metrics.add_consumer()});
+			started.store(true, std::memory_order_release);
+			return ptr;
+		}
+
+		//A log call of synchronous dispatcher doesn't throw, so exceptions of its consumers are counted in metrics only
+		static exception_handler_t get_default_exception_handler(dispatch_mode mode)
+		{
+			if (mode == dispatch_mode::synchronous)
+				return [] (std::exception_ptr) {};
+			return [] (std::exception_ptr ptr) {
+				std::rethrow_exception(ptr);
+			};
+		}
+
+		//Records logged by consumers themselves are passed after the current record instead of recursion.
+		//Exceptions of consumers go to the exception handler; if it throws, the log call still doesn't.
+		void push_inline(tags_handle_t&& tags)
+		{
+			std::lock_guard<std::recursive_mutex> lock(inline_mutex);
+			if (is_stopped())
+				return metrics.on_drop(1);
+			deferred.push_back(record{metrics.on_push(), next_sequence++, std::move(tags)});
+			if (inline_dispatching)
+				return;
+
+			inline_dispatching = true;
+			try {
+				while (!deferred.empty())
+				{
+					auto r = std::move(deferred.front());
+					deferred.pop_front();
+					dispatch(r);
+				}
+			} catch (...) {
+				//records logged by the failed consumer are not passed with an unrelated later record
+				metrics.on_drop_queued(deferred.size());
+				deferred.clear();
+			}
+			inline_dispatching = false;
+			erase_removed();
+		}
+
+		//Consumers which are destroyed while dispatch iterates them
+		void erase_removed()
+		{
+			auto list = std::move(removed);
+			removed.clear();
+			for (const auto& ptr : list)
+				consumers.erase(ptr.get());
+		}
+
+		void unsubscribe(std::unique_ptr<consumer_fn> ptr)
+		{
+			if (options.mode == dispatch_mode::synchronous)
+			{
+				std::lock_guard<std::recursive_mutex> lock(inline_mutex);
+				const auto iter = consumers.find(ptr.get());
+				if (iter == consumers.end())
+					return;
+				metrics.remove_consumer(iter->second.stats);
+				//a consumer drops a subscription while dispatch iterates consumers on this thread
+				if (inline_dispatching)
+				{
+					iter->second.removed = true;
+					removed.push_back(std::move(ptr));
+					return;
+				}
+				consumers.erase(iter);
+				return;
+			}
+
+			//records held by a strict subscription are passed when the previous ones are dispatched
+			{
+				std::unique_lock<std::mutex> lock(lanes_mutex);
+				const auto target = next_sequence;
+				++flush_waiters;
+				flushed.wait(lock, [this, target] {
+					return is_dispatched_before(target);
+				});
+				--flush_waiters;
+			}
+
 			std::promise<void> promise;
 			auto future = promise.get_future();
-			queue.push([this, ptr, &promise] () mutable {
-				consumers.erase(ptr);
+			post([this, ptr = ptr.get(), &promise] () mutable {
+				{
+					std::lock_guard<std::mutex> lock(lanes_mutex);
+					const auto iter = pending_consumers.find(ptr);
+					if (iter != pending_consumers.end())
+					{
+						metrics.remove_consumer(iter->second.stats);
+						pending_consumers.erase(iter);
+					}
+				}
+				const auto iter = consumers.find(ptr);
+				if (iter != consumers.end())
+				{
+					metrics.on_drop(release_pending(iter->second));
+					metrics.remove_consumer(iter->second.stats);
+					consumers.erase(iter);
+				}
 				promise.set_value();
 			});
 			future.wait();
 		}
 
 	private:
-		void dispatch(const tags_handle_t& tags)
+		//Should be called under lanes_mutex
+		void start()
+		{
+			details::lanes_change change(lanes_changing);
+			in_flight.reserve(details::drain_batch_size);
+			if (options.shared_worker)
+			{
+				queue = shared_worker();
+				alive = std::make_shared<bool>(true);
+			}
+			else
+				queue = std::make_shared<worker>([this] (std::exception_ptr ptr) {
+					handle(ptr);
+				}, options.worker);
+		}
+
+		//Exceptions of a shared worker are routed to the handler of the dispatcher.
+		//The tasks of a shared worker are counted, so destructor waits for them.
+		template <typename task_t>
+		void post(task_t&& task)
+		{
+			if (!options.shared_worker)
+				return queue->push(std::forward<task_t>(task));
+			{
+				std::lock_guard<std::mutex> lock(lanes_mutex);
+				++posted;
+			}
+			queue->push([this, self = this->weak_from_this(), alive = alive, task = std::forward<task_t>(task)] () mutable {
+				if (!*alive)
+					return;
+				const auto keep = self.lock();
+				try {
+					task();
+				} catch (...) {
+					handle(std::current_exception());
+				}
+				std::lock_guard<std::mutex> lock(lanes_mutex);
+				if (--posted == 0)
+					flushed.notify_all();
+			});
+		}
+
+		void schedule_drain()
+		{
+			post([this] {
+				drain();
+			});
+		}
+
+		//Drains the lanes, the highest non-empty lane first; a lane skipped lane_quota times goes first.
+		//Only one drain task is scheduled at a time, so pushing to non-empty lanes costs no extra task.
+		//The task is rescheduled after a few batches to let subscribe/unsubscribe go through under load.
+		//If the exception handler throws, the failed record is skipped and the next task passes the rest of batch.
+		void drain()
+		{
+			try {
+				for (std::size_t index = 0; index < details::drain_batches_per_task; ++index)
+				{
+					if (!take_batch())
+						return;
+					dispatch_batch();
+				}
+			} catch (...) {
+				skip_failed_record();
+				schedule_drain();
+				throw;
+			}
+			schedule_drain();
+		}
+
+		void skip_failed_record()
+		{
+			details::lanes_change change(lanes_changing);
+			const auto position = in_flight_position.load(std::memory_order_relaxed);
+			if (position < in_flight.size())
+				in_flight_position.store(position + 1, std::memory_order_relaxed);
+		}
+
+		//Continues the batch which is interrupted by exception
+		void dispatch_batch()
+		{
+			for (auto position = in_flight_position.load(std::memory_order_relaxed); position < in_flight.size(); ++position)
+			{
+				in_flight_position.store(position, std::memory_order_relaxed);
+				dispatch(in_flight[position]);
+			}
+			in_flight_position.store(in_flight.size(), std::memory_order_relaxed);
+		}
+
+		//in_flight is changed under lanes_changing only, so visit_pending may read it
+		bool take_batch()
+		{
+			std::lock_guard<std::mutex> lock(lanes_mutex);
+			details::lanes_change change(lanes_changing);
+			if (flush_waiters != 0)
+				flushed.notify_all();
+			consumers.merge(pending_consumers);
+			if (in_flight_position.load(std::memory_order_relaxed) < in_flight.size())
+				return true;
+			in_flight.clear();
+			in_flight_position.store(0, std::memory_order_relaxed);
+
+			const auto index = get_next_lane();
+			if (index == details::lanes_count)
+			{
+				drain_scheduled = false;
+				return false;
+			}
+			for (auto lower = index + 1; lower < details::lanes_count; ++lower)
+				if (!lanes[lower].empty())
+					++skipped[lower];
+			skipped[index] = 0;
+
+			auto& lane = lanes[index];
+			const auto count = std::min(details::drain_batch_size, lane.size());
+			std::move(lane.begin(), lane.begin() + count, std::back_inserter(in_flight));
+			lane.erase(lane.begin(), lane.begin() + count);
+			return true;
+		}
+
+		//Should be called under lanes_mutex; returns lanes_count if the lanes are empty
+		std::size_t get_next_lane() const
 		{
-			for (auto& c : consumers)
+			for (auto index = details::lanes_count; index-- > 0; )
+				if (!lanes[index].empty() && skipped[index] >= details::lane_quota)
+					return index;
+			for (std::size_t index = 0; index < details::lanes_count; ++index)
+				if (!lanes[index].empty())
+					return index;
+			return details::lanes_count;
+		}
+
+		//Should be called under lanes_mutex
+		bool is_dispatched_before(std::uint64_t sequence) const
+		{
+			for (const auto& lane : lanes)
+				if (!lane.empty() && lane.front().sequence < sequence)
+					return false;
+			for (auto position = in_flight_position.load(std::memory_order_relaxed); position < in_flight.size(); ++position)
+				if (in_flight[position].sequence < sequence)
+					return false;
+			return held.empty() || held.begin()->first >= sequence;
+		}
+
+		bool is_stopped()
+		{
+			std::lock_guard<std::mutex> lock(lanes_mutex);
+			return stopped;
+		}
+
+		std::map<consumer_fn*, subscription> get_pending_consumers()
+		{
+			std::map<consumer_fn*, subscription> result;
+			std::lock_guard<std::mutex> lock(lanes_mutex);
+			result.swap(pending_consumers);
+			return result;
+		}
+
+		struct consumer_functions
+		{
+			details::deadline_flush_fn flush;
+			details::stop_fn stop;
+		};
+
+		//Called on the dispatcher thread
+		std::vector<consumer_functions> get_consumer_functions() const
+		{
+			std::vector<consumer_functions> result;
+			for (const auto& [c, s] : consumers)
+				if (s.flush || s.stop)
+					result.push_back({s.flush, s.stop});
+			return result;
+		}
+
+		//Synchronous dispatcher calls the functions out of inline_mutex:
+		//a consumer with own queue waits for its thread, which may log
+		std::vector<consumer_functions> get_inline_consumer_functions()
+		{
+			std::lock_guard<std::recursive_mutex> lock(inline_mutex);
+			return get_consumer_functions();
+		}
+
+		//Returns false if a consumer reached deadline first
+		bool flush_consumers(const std::vector<consumer_functions>& functions, const time_point_t& deadline)
+		{
+			bool result = true;
+			for (const auto& f : functions)
+			{
+				if (!f.flush)
+					continue;
+				try {
+					result = f.flush(deadline) && result;
+				} catch (...) {
+					handle(std::current_exception());
+				}
+			}
+			return result;
+		}
+
+		//Returns count of the records which are left in the queues of consumers
+		std::size_t stop_consumers(const std::vector<consumer_functions>& functions)
+		{
+			std::size_t count = 0;
+			for (const auto& f : functions)
 			{
+				if (!f.stop)
+					continue;
 				try {
-					(*c)(tags);
+					count += f.stop();
 				} catch (...) {
 					handle(std::current_exception());
 				}
 			}
+			metrics.on_drop(count);
+			return count;
+		}
+
+		//The record may be moved out, so it's the last use of it
+		void dispatch(record& r)
+		{
+			metrics.on_dispatch(r);
+
+			//text consumers share the rendered forms of record even if traits don't keep a cache in it
+			std::optional<details::dispatch_render_scope> render_scope;
+			if (is_render_shared())
+				render_scope.emplace(&r.tags);
+
+			bool delivered = false;
+			std::size_t holders = 0;
+			for (auto& [c, s] : consumers)
+			{
+				if (s.removed || r.sequence < s.first)
+					continue;
+				delivered = true;
+				if (s.order == ordering::relaxed)
+					call(*c, s, r.tags);
+				else if (r.sequence == s.next)
+					dispatch_strict(*c, s, r);
+				else
+					++holders;
+			}
+
+			if (!delivered)
+				metrics.on_undelivered(1);
+			if (holders == 0)
+				return;
+
+			//strict subscriptions hold the overtaking record until all the records pushed before it are passed
+			const auto ptr = park(r, holders);
+			for (auto& [c, s] : consumers)
+				if (s.order == ordering::strict && !s.removed && ptr->sequence >= s.first && ptr->sequence > s.next)
+					s.pending.push(ptr);
+		}
+
+		void dispatch_strict(const consumer_fn& consumer, subscription& s, const record& r)
+		{
+			call(consumer, s, r.tags);
+			++s.next;
+			while (!s.pending.empty() && s.pending.top()->sequence == s.next)
+			{
+				call(consumer, s, s.pending.top()->tags);
+				release(s.pending.top()->sequence);
+				s.pending.pop();
+				++s.next;
+			}
+		}
+
+		//The record is not visited by visit_pending after it's moved out of in_flight,
+		//but it's counted in held until all the holders pass it
+		record_ptr park(record& r, std::size_t holders)
+		{
+			std::lock_guard<std::mutex> lock(lanes_mutex);
+			details::lanes_change change(lanes_changing);
+			const auto position = in_flight_position.load(std::memory_order_relaxed);
+			if (position < in_flight.size() && &in_flight[position] == &r)
+				in_flight_position.store(position + 1, std::memory_order_relaxed);
+			held.emplace(r.sequence, holders);
+			return std::make_shared<const record>(std::move(r));
+		}
+
+		void release(std::uint64_t sequence)
+		{
+			std::lock_guard<std::mutex> lock(lanes_mutex);
+			const auto iter = held.find(sequence);
+			if (iter != held.end() && --iter->second == 0)
+				held.erase(iter);
+			if (flush_waiters != 0)
+				flushed.notify_all();
+		}
+
+		//Returns count of the records which are not passed to the consumer
+		std::size_t release_pending(subscription& s)
+		{
+			const auto count = s.pending.size();
+			for (; !s.pending.empty(); s.pending.pop())
+				release(s.pending.top()->sequence);
+			return count;
+		}
+
+		void call(const consumer_fn& consumer, subscription& s, const tags_handle_t& tags)
+		{
+			if constexpr (metrics_t::enabled)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				call_impl(consumer, tags);
+				metrics.on_consumer_call(*s.stats, std::chrono::steady_clock::now() - start);
+			}
+			else
+				call_impl(consumer, tags);
+		}
+
+		void call_impl(const consumer_fn& consumer, const tags_handle_t& tags)
+		{
+			try {
+				consumer(tags);
+			} catch (...) {
+				handle(std::current_exception());
+			}
 		}
 
 		void handle(std::exception_ptr ptr)
 		{
+			metrics.on_exception();
 			exception_handler(ptr);
 		}
 
 	private:
 		exception_handler_t exception_handler;
-		std::set<consumer_fn*> consumers;
-		utils::task_queue queue;
+		const dispatcher_options options;
+		std::atomic_bool started {false};
+		std::atomic<std::size_t> text_consumers {0};
+		metrics_t metrics;
+		std::map<consumer_fn*, subscription> consumers;
+
+		std::mutex lanes_mutex;
+		std::map<consumer_fn*, subscription> pending_consumers;
+		std::array<std::deque<record>, details::lanes_count> lanes;
+		std::array<std::size_t, details::lanes_count> skipped {};	//batches taken from higher lanes while the lane waits
+		std::uint64_t next_sequence = 0;
+		bool drain_scheduled = false;
+		bool stopped = false;
+		std::condition_variable flushed;
+		std::size_t flush_waiters = 0;
+		std::vector<record> in_flight;
+		std::atomic<std::size_t> in_flight_position {0};
+		std::atomic_flag lanes_changing = ATOMIC_FLAG_INIT;
+		std::map<std::uint64_t, std::size_t> held;	//sequence of record parked by strict subscriptions -> count of them
+		std::size_t posted = 0;		//tasks of shared worker which are not finished
+		std::shared_ptr<bool> alive;	//false after destruction by a task of shared worker; changed and read by the worker only
+
+		std::recursive_mutex inline_mutex;
+		std::deque<record> deferred;
+		bool inline_dispatching = false;
+		std::vector<std::unique_ptr<consumer_fn>> removed;
+
+		std::shared_ptr<worker> queue;
 	};
 } //namespace charivari_ltd::loggerpp
-
@@ -37,9 +37,38 @@
 
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace charivari_ltd::loggerpp
 {
+	//Argument which is evaluated by formatter only, i.e. when the record is enabled and consumed
+	template <typename fn_t>
+	struct lazy_arg
+	{
+		fn_t fn;
+
+		decltype(auto) operator () () const
+		{
+			return fn();
+		}
+	};
+
+	template <typename fn_t>
+	inline lazy_arg<std::decay_t<fn_t>> lazy(fn_t&& fn)
+	{
+		return {std::forward<fn_t>(fn)};
+	}
+
+	namespace details
+	{
+		template <typename arg_t>
+		struct is_lazy_arg : std::false_type {};
+
+		template <typename fn_t>
+		struct is_lazy_arg<lazy_arg<fn_t>> : std::true_type {};
+	} //namespace details
+
 	struct default_formatter
 	{
 		template <typename ... args_t>
@@ -85,7 +114,9 @@ namespace charivari_ltd::loggerpp
 		template <typename string_t, typename arg_t>
 		static string_t to_string_t(arg_t&& arg)
 		{
-			if constexpr (std::is_same_v<std::decay_t<string_t>, std::string>)
+			if constexpr (details::is_lazy_arg<std::decay_t<arg_t>>::value)
+				return to_string_t<string_t>(arg());
+			else if constexpr (std::is_same_v<std::decay_t<string_t>, std::string>)
 				return utils::to_string(arg);
 			else if constexpr (std::is_same_v<std::decay_t<string_t>, std::wstring>)
 				return utils::to_wstring(arg);
@@ -0,0 +1,392 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "logger.h"
+#include "binary_log_reader.h"
+#include "file_log_consumer.h"
+
+#include <utils/noncopyable.h>
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace charivari_ltd::loggerpp
+{
+namespace details
+{
+	//Read-only mapping of the whole file. Pages are read ahead by window and dropped behind the reader,
+	//so resident memory stays bounded for any size of the file.
+	class mapped_file :
+		public utils::noncopyable
+	{
+	public:
+		static constexpr std::size_t window = 8 << 20;
+
+	public:
+		explicit mapped_file(const std::string& path)
+		{
+#if defined(__unix__) || defined(__APPLE__)
+			const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				throw std::system_error(errno, std::generic_category(), "open " + path);
+			struct stat info {};
+			if (::fstat(fd, &info) != 0)
+			{
+				const auto error = errno;
+				::close(fd);
+				throw std::system_error(error, std::generic_category(), "fstat " + path);
+			}
+			size = static_cast<std::size_t>(info.st_size);
+			if (size != 0)
+			{
+				const auto ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (ptr == MAP_FAILED)
+				{
+					const auto error = errno;
+					::close(fd);
+					throw std::system_error(error, std::generic_category(), "mmap " + path);
+				}
+				data = static_cast<const char*>(ptr);
+				::madvise(ptr, size, MADV_SEQUENTIAL);
+				::madvise(ptr, std::min(size, window), MADV_WILLNEED);
+			}
+			::close(fd);
+#else
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+				throw std::runtime_error("can't open " + path);
+			buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			data = buffer.data();
+			size = buffer.size();
+#endif
+		}
+
+		~mapped_file()
+		{
+#if defined(__unix__) || defined(__APPLE__)
+			if (size != 0)
+				::munmap(const_cast<char*>(data), size);
+#endif
+		}
+
+	public:
+		std::string_view get_view() const
+		{
+			return {data, size};
+		}
+
+		//Called by reader as it goes forward
+		void advance(std::size_t position)
+		{
+#if defined(__unix__) || defined(__APPLE__)
+			while (position >= next_window)
+			{
+				::madvise(const_cast<char*>(data) + next_window - window, window, MADV_DONTNEED);
+				if (next_window < size)
+					::madvise(const_cast<char*>(data) + next_window, std::min(window, size - next_window), MADV_WILLNEED);
+				next_window += window;
+			}
+#else
+			(void)position;
+#endif
+		}
+
+	private:
+		const char* data = nullptr;
+		std::size_t size = 0;
+		std::size_t next_window = window;
+#if !defined(__unix__) && !defined(__APPLE__)
+		std::string buffer;
+#endif
+	};
+
+	template <typename traits_t>
+	class merge_source
+	{
+	public:
+		using tags_handle_t = typename traits_t::tags_handle_t;
+
+	public:
+		virtual ~merge_source() = default;
+
+		//Goes to the next record; false at the end
+		virtual bool next() = 0;
+		virtual void write(std::ostream& out) = 0;
+		virtual tags_handle_t get_tags() = 0;
+
+		std::int64_t get_time() const
+		{
+			return time;
+		}
+
+	protected:
+		std::int64_t time = std::numeric_limits<std::int64_t>::min();
+	};
+
+	//Lines of file_log_consumer: time in nanoseconds, level, message, key=value...
+	//A line which doesn't start with time continues the previous record.
+	template <typename traits_t>
+	class text_merge_source :
+		public merge_source<traits_t>
+	{
+	public:
+		using typename merge_source<traits_t>::tags_handle_t;
+		using tags_t = typename traits_t::tags_t;
+
+	public:
+		explicit text_merge_source(const std::string& path) :
+			file(path),
+			view(file.get_view())
+		{}
+
+		bool next() override
+		{
+			if (position >= view.size())
+				return false;
+			const auto begin = position;
+			do
+				position = get_line_end(position);
+			while (position < view.size() && !get_time_at(position));
+			if (const auto t = get_time_at(begin))
+				this->time = *t;
+			record = view.substr(begin, position - begin);
+			while (!record.empty() && (record.back() == '\n' || record.back() == '\r'))
+				record.remove_suffix(1);
+			file.advance(position);
+			return true;
+		}
+
+		void write(std::ostream& out) override
+		{
+			out.write(record.data(), static_cast<std::streamsize>(record.size()));
+			out.put('\n');
+		}
+
+		//Types of values except of time and level are lost in text, so other values are strings
+		tags_handle_t get_tags() override
+		{
+			tags_t tags;
+			std::size_t index = 0;
+			for (std::size_t begin = 0; begin <= record.size(); ++index)
+			{
+				auto end = record.find('\t', begin);
+				if (end == std::string_view::npos)
+					end = record.size();
+				const std::string field(record.substr(begin, end - begin));
+				begin = end + 1;
+
+				if (index == constants::index_time)
+					tags.push_back({constants::key_time, from_nanoseconds(this->time)});
+				else if (index == constants::index_level)
+				{
+					if (const auto lvl = parse_level(field))
+						tags.push_back({constants::key_level, *lvl});
+					else
+						tags.push_back({constants::key_level, field});
+				}
+				else if (index == constants::index_message)
+					tags.push_back({constants::key_message, field});
+				else
+				{
+					const auto separator = field.find('=');
+					if (separator == std::string::npos)
+						tags.push_back({std::string{}, field});
+					else
+						tags.push_back({field.substr(0, separator), field.substr(separator + 1)});
+				}
+			}
+			return traits_t::make_tags_handle(std::move(tags));
+		}
+
+	private:
+		std::size_t get_line_end(std::size_t begin) const
+		{
+			const auto end = view.find('\n', begin);
+			return end == std::string_view::npos ? view.size() : end + 1;
+		}
+
+		std::optional<std::int64_t> get_time_at(std::size_t begin) const
+		{
+			std::int64_t value = 0;
+			std::size_t end = begin;
+			for (; end < view.size() && view[end] >= '0' && view[end] <= '9'; ++end)
+				value = value * 10 + (view[end] - '0');
+			if (end == begin || (end < view.size() && view[end] != '\t' && view[end] != '\n' && view[end] != '\r'))
+				return std::nullopt;
+			return value;
+		}
+
+		static std::chrono::system_clock::time_point from_nanoseconds(std::int64_t ns)
+		{
+			return binary_log::from_nanoseconds(ns);
+		}
+
+	private:
+		mapped_file file;
+		std::string_view view;
+		std::size_t position = 0;
+		std::string_view record;
+	};
+
+	//Keeps one block of records in memory
+	template <typename traits_t>
+	class binary_merge_source :
+		public merge_source<traits_t>
+	{
+	public:
+		using typename merge_source<traits_t>::tags_handle_t;
+
+	public:
+		explicit binary_merge_source(const std::string& path) :
+			reader(path)
+		{}
+
+		bool next() override
+		{
+			if (!records.empty())
+				records.pop_front();
+			while (records.empty())
+			{
+				if (block == reader.get_blocks().size())
+					return false;
+				reader.read_block(block++, [this] (tags_handle_t&& tags) {
+					records.push_back(std::move(tags));
+				});
+			}
+			const auto& tags = traits_t::extract_tags(records.front());
+			if (tags.size() > constants::index_time)
+				if (const auto t = std::get_if<std::chrono::system_clock::time_point>(&tags[constants::index_time].value))
+					this->time = binary_log::to_nanoseconds(*t);
+			return true;
+		}
+
+		void write(std::ostream& out) override
+		{
+			write_text_record<traits_t>(out, traits_t::extract_tags(records.front()));
+		}
+
+		tags_handle_t get_tags() override
+		{
+			return records.front();
+		}
+
+	private:
+		binary_log_reader<traits_t> reader;
+		std::size_t block = 0;
+		std::deque<tags_handle_t> records;
+	};
+
+	inline bool is_binary_log(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::uint32_t magic = 0;
+		file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		return file && magic == binary_log::file_magic;
+	}
+
+	template <typename traits_t>
+	inline std::unique_ptr<merge_source<traits_t>> open_merge_source(const std::string& path)
+	{
+		if (is_binary_log(path))
+			return std::make_unique<binary_merge_source<traits_t>>(path);
+		return std::make_unique<text_merge_source<traits_t>>(path);
+	}
+
+	//Calls visitor(source) for records of all the sources in order of time;
+	//records of equal time keep order of the sources. Each source is expected to be ordered by time.
+	template <typename traits_t, typename visitor_t>
+	inline std::size_t merge_sources(const std::vector<std::string>& paths, visitor_t&& visitor)
+	{
+		std::vector<std::unique_ptr<merge_source<traits_t>>> sources;
+		for (const auto& path : paths)
+			sources.push_back(open_merge_source<traits_t>(path));
+
+		using item_t = std::pair<std::int64_t, std::size_t>;
+		std::priority_queue<item_t, std::vector<item_t>, std::greater<item_t>> heap;
+		for (std::size_t index = 0; index < sources.size(); ++index)
+			if (sources[index]->next())
+				heap.emplace(sources[index]->get_time(), index);
+
+		std::size_t count = 0;
+		while (!heap.empty())
+		{
+			const auto index = heap.top().second;
+			heap.pop();
+			visitor(*sources[index]);
+			++count;
+			if (sources[index]->next())
+				heap.emplace(sources[index]->get_time(), index);
+		}
+		return count;
+	}
+} //namespace details
+
+	//Merges text files of file_log_consumer and binary logs by time into text stream; returns count of records.
+	//Text records are copied as is.
+	template <typename traits_t = default_log_traits>
+	inline std::size_t merge_logs(const std::vector<std::string>& paths, std::ostream& out)
+	{
+		return details::merge_sources<traits_t>(paths, [&out] (details::merge_source<traits_t>& source) {
+			source.write(out);
+		});
+	}
+
+	//Merges files by time and passes the records to consumer(const tags_handle_t&), e.g. to a dispatcher
+	template <typename traits_t, typename consumer_t>
+	inline std::size_t merge_logs(const std::vector<std::string>& paths, consumer_t&& consumer)
+	{
+		return details::merge_sources<traits_t>(paths, [&consumer] (details::merge_source<traits_t>& source) {
+			consumer(source.get_tags());
+		});
+	}
+} //namespace charivari_ltd::loggerpp
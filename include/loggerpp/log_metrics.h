@@ -0,0 +1,334 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace charivari_ltd::loggerpp
+{
+	//HDR-style log-linear buckets: each power of two is split to sub_buckets_count buckets, so error is below 12.5%
+	struct histogram_snapshot
+	{
+		static const std::size_t sub_buckets_bits = 3;
+		static const std::size_t sub_buckets_count = 1 << sub_buckets_bits;
+		static const std::size_t buckets_count = 64 * sub_buckets_count;
+
+		std::array<std::uint64_t, buckets_count> buckets {};
+		std::uint64_t count = 0;
+		std::uint64_t sum = 0;
+		std::uint64_t max = 0;
+
+		static std::size_t get_bucket(std::uint64_t value)
+		{
+			if (value < sub_buckets_count)
+				return static_cast<std::size_t>(value);
+			std::size_t magnitude = 0;
+			for (auto v = value; v > 1; v >>= 1)
+				++magnitude;
+			const auto shift = magnitude - sub_buckets_bits;
+			const auto sub_bucket = static_cast<std::size_t>(value >> shift) - sub_buckets_count;
+			return (shift + 1) * sub_buckets_count + sub_bucket;
+		}
+
+		static std::uint64_t get_upper_bound(std::size_t bucket)
+		{
+			if (bucket < sub_buckets_count)
+				return bucket;
+			const auto shift = bucket / sub_buckets_count - 1;
+			const auto sub_bucket = bucket % sub_buckets_count;
+			const auto lower = static_cast<std::uint64_t>(sub_buckets_count + sub_bucket) << shift;
+			return lower + ((std::uint64_t{1} << shift) - 1);
+		}
+
+		//Returns upper bound of the bucket which holds p-th percentile; p in [0, 1]
+		std::uint64_t percentile(double p) const
+		{
+			if (count == 0)
+				return 0;
+			const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(p * count)));
+			std::uint64_t seen = 0;
+			for (std::size_t index = 0; index < buckets_count; ++index)
+			{
+				seen += buckets[index];
+				if (seen >= rank)
+					return std::min(max, get_upper_bound(index));
+			}
+			return max;
+		}
+
+		double mean() const
+		{
+			return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+		}
+	};
+
+	class histogram
+	{
+	public:
+		void record(std::uint64_t value)
+		{
+			buckets[histogram_snapshot::get_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+			count.fetch_add(1, std::memory_order_relaxed);
+			sum.fetch_add(value, std::memory_order_relaxed);
+			auto current = max.load(std::memory_order_relaxed);
+			while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+				;
+		}
+
+		histogram_snapshot get_snapshot() const
+		{
+			histogram_snapshot result;
+			for (std::size_t index = 0; index < histogram_snapshot::buckets_count; ++index)
+				result.buckets[index] = buckets[index].load(std::memory_order_relaxed);
+			result.count = count.load(std::memory_order_relaxed);
+			result.sum = sum.load(std::memory_order_relaxed);
+			result.max = max.load(std::memory_order_relaxed);
+			return result;
+		}
+
+	private:
+		std::array<std::atomic<std::uint64_t>, histogram_snapshot::buckets_count> buckets {};
+		std::atomic<std::uint64_t> count {0};
+		std::atomic<std::uint64_t> sum {0};
+		std::atomic<std::uint64_t> max {0};
+	};
+
+	struct consumer_snapshot
+	{
+		std::uint64_t id = 0;					//consumers are numbered in order of subscribe
+		histogram_snapshot call;				//nanoseconds per record
+	};
+
+	struct metrics_snapshot
+	{
+		std::uint64_t pushed = 0;
+		std::uint64_t dispatched = 0;
+		std::uint64_t queue_depth = 0;
+		std::uint64_t queue_depth_high_water = 0;
+		std::uint64_t exceptions = 0;
+		std::uint64_t dropped = 0;				//records which are lost: pushed after shutdown, left by shutdown or unsubscribe
+		std::uint64_t undelivered = 0;			//records which are logged while no consumer is subscribed
+		histogram_snapshot push_to_dispatch;	//nanoseconds
+		histogram_snapshot consumer_call;		//nanoseconds per consumer per record, all the consumers
+		std::vector<consumer_snapshot> consumers;
+	};
+
+	//Default: all the calls are empty and are removed by compiler
+	struct no_metrics
+	{
+		static constexpr bool enabled = false;
+
+		struct stamp_t {};
+		struct consumer_stats {};
+		using consumer_stats_ptr = std::shared_ptr<consumer_stats>;
+
+		stamp_t on_push() { return {}; }
+		void on_dispatch(const stamp_t&) {}
+		consumer_stats_ptr add_consumer() { return nullptr; }
+		void remove_consumer(const consumer_stats_ptr&) {}
+		void on_consumer_call(consumer_stats&, std::chrono::steady_clock::duration) {}
+		void on_exception() {}
+		void on_drop(std::size_t) {}
+		void on_drop_queued(std::size_t) {}
+		void on_undelivered(std::size_t) {}
+
+		metrics_snapshot get_snapshot() const { return {}; }
+	};
+
+	class atomic_metrics
+	{
+	public:
+		static constexpr bool enabled = true;
+
+		struct stamp_t
+		{
+			std::chrono::steady_clock::time_point pushed;
+		};
+
+		struct consumer_stats
+		{
+			explicit consumer_stats(std::uint64_t id) :
+				id(id)
+			{}
+
+			const std::uint64_t id;
+			histogram call;
+		};
+		using consumer_stats_ptr = std::shared_ptr<consumer_stats>;
+
+	public:
+		atomic_metrics() = default;
+
+		atomic_metrics(const atomic_metrics&) = delete;
+		atomic_metrics& operator = (const atomic_metrics&) = delete;
+
+		~atomic_metrics()
+		{
+			delete consumers.load();
+		}
+
+	public:
+		stamp_t on_push()
+		{
+			const auto count = pushed.fetch_add(1, std::memory_order_relaxed) + 1;
+			const auto depth = get_queue_depth(count, dispatched.load(std::memory_order_relaxed), dropped_queued.load(std::memory_order_relaxed));
+			auto current = high_water.load(std::memory_order_relaxed);
+			while (current < depth && !high_water.compare_exchange_weak(current, depth, std::memory_order_relaxed))
+				;
+			return {std::chrono::steady_clock::now()};
+		}
+
+		void on_dispatch(const stamp_t& stamp)
+		{
+			dispatched.fetch_add(1, std::memory_order_relaxed);
+			push_to_dispatch.record(to_nanoseconds(std::chrono::steady_clock::now() - stamp.pushed));
+		}
+
+		//Changes of the list of consumers are serialized by the mutex: the list is copied and published by pointer,
+		//and the old copies are deleted when no snapshot reads them, so snapshots don't lock
+		consumer_stats_ptr add_consumer()
+		{
+			std::lock_guard<std::mutex> lock(consumers_mutex);
+			auto list = std::make_unique<consumers_list>(*consumers.load());
+			list->push_back(std::make_shared<consumer_stats>(next_consumer_id++));
+			auto stats = list->back();
+			publish(std::move(list));
+			return stats;
+		}
+
+		void remove_consumer(const consumer_stats_ptr& stats)
+		{
+			std::lock_guard<std::mutex> lock(consumers_mutex);
+			auto list = std::make_unique<consumers_list>(*consumers.load());
+			list->erase(std::remove(list->begin(), list->end(), stats), list->end());
+			publish(std::move(list));
+		}
+
+		void on_consumer_call(consumer_stats& stats, std::chrono::steady_clock::duration duration)
+		{
+			const auto ns = to_nanoseconds(duration);
+			consumer_call.record(ns);
+			stats.call.record(ns);
+		}
+
+		void on_exception()
+		{
+			exceptions.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void on_drop(std::size_t count)
+		{
+			dropped.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		//Records which are pushed, but dropped before dispatch: they leave the queue
+		void on_drop_queued(std::size_t count)
+		{
+			dropped_queued.fetch_add(count, std::memory_order_relaxed);
+			on_drop(count);
+		}
+
+		void on_undelivered(std::size_t count)
+		{
+			undelivered.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		metrics_snapshot get_snapshot() const
+		{
+			metrics_snapshot result;
+			result.dispatched = dispatched.load(std::memory_order_relaxed);
+			result.pushed = pushed.load(std::memory_order_relaxed);
+			result.queue_depth = get_queue_depth(result.pushed, result.dispatched, dropped_queued.load(std::memory_order_relaxed));
+			result.queue_depth_high_water = high_water.load(std::memory_order_relaxed);
+			result.exceptions = exceptions.load(std::memory_order_relaxed);
+			result.dropped = dropped.load(std::memory_order_relaxed);
+			result.undelivered = undelivered.load(std::memory_order_relaxed);
+			result.push_to_dispatch = push_to_dispatch.get_snapshot();
+			result.consumer_call = consumer_call.get_snapshot();
+			readers.fetch_add(1);
+			for (const auto& stats : *consumers.load())
+				result.consumers.push_back({stats->id, stats->call.get_snapshot()});
+			readers.fetch_sub(1);
+			return result;
+		}
+
+	private:
+		using consumers_list = std::vector<consumer_stats_ptr>;
+
+		//Should be called under consumers_mutex.
+		//A snapshot counts itself in readers before it loads the list, so the replaced lists are free when readers is 0.
+		void publish(std::unique_ptr<consumers_list> list)
+		{
+			retired.emplace_back(consumers.exchange(list.release()));
+			if (readers.load() == 0)
+				retired.clear();
+		}
+
+		//Counters are read one by one, so the sum may be ahead of pushed
+		static std::uint64_t get_queue_depth(std::uint64_t pushed, std::uint64_t dispatched, std::uint64_t dropped)
+		{
+			return pushed > dispatched + dropped ? pushed - dispatched - dropped : 0;
+		}
+
+		static std::uint64_t to_nanoseconds(std::chrono::steady_clock::duration duration)
+		{
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+		}
+
+	private:
+		std::atomic<std::uint64_t> pushed {0};
+		std::atomic<std::uint64_t> dispatched {0};
+		std::atomic<std::uint64_t> high_water {0};
+		std::atomic<std::uint64_t> exceptions {0};
+		std::atomic<std::uint64_t> dropped {0};
+		std::atomic<std::uint64_t> dropped_queued {0};
+		std::atomic<std::uint64_t> undelivered {0};
+		histogram push_to_dispatch;
+		histogram consumer_call;
+
+		std::mutex consumers_mutex;		//serializes changes of the list
+		std::atomic<const consumers_list*> consumers {new consumers_list()};
+		mutable std::atomic<std::size_t> readers {0};
+		std::vector<std::unique_ptr<const consumers_list>> retired;		//replaced lists which snapshots may still read
+		std::uint64_t next_consumer_id = 0;
+	};
+} //namespace charivari_ltd::loggerpp
@@ -0,0 +1,102 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "logger.h"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace charivari_ltd::loggerpp
+{
+	//Passes records of lvl and above to the next stages of pipeline
+	template <level lvl>
+	struct level_filter
+	{
+		template <typename tags_handle_t>
+		bool operator () (const tags_handle_t& tags_handle) const
+		{
+			return get_level(tags_handle) >= lvl;
+		}
+	};
+
+	//Consumers composed at compile time: the stages are called directly, so the compiler may inline and fuse them.
+	//A stage returning bool is a filter: false stops the record for the next stages.
+	//The pipeline is subscribed as one consumer; the dynamic subscribe stays for consumers chosen at runtime.
+	template <typename ... stages_t>
+	class pipeline
+	{
+	public:
+		pipeline() = default;
+
+		explicit pipeline(stages_t ... stages) :
+			stages(std::move(stages)...)
+		{}
+
+	public:
+		template <typename tags_handle_t>
+		void operator () (const tags_handle_t& tags_handle)
+		{
+			call<0>(tags_handle);
+		}
+
+	private:
+		template <std::size_t index, typename tags_handle_t>
+		void call(const tags_handle_t& tags_handle)
+		{
+			if constexpr (index < sizeof...(stages_t))
+			{
+				auto& stage = std::get<index>(stages);
+				if constexpr (std::is_same_v<decltype(stage(tags_handle)), bool>)
+				{
+					if (!stage(tags_handle))
+						return;
+				}
+				else
+					stage(tags_handle);
+				call<index + 1>(tags_handle);
+			}
+		}
+
+	private:
+		std::tuple<stages_t...> stages;
+	};
+
+	template <typename ... stages_t>
+	inline auto make_pipeline(stages_t&& ... stages)
+	{
+		return pipeline<std::decay_t<stages_t>...>(std::forward<stages_t>(stages)...);
+	}
+} //namespace charivari_ltd::loggerpp
@@ -0,0 +1,200 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "log_level.h"
+
+#include <utils/noncopyable.h>
+
+#include <atomic>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace charivari_ltd::loggerpp
+{
+	using level_ptr = std::shared_ptr<const std::atomic<level>>;
+
+	namespace details
+	{
+		//Threshold of loggers which are not bound to a registry: everything is enabled
+		inline const level_ptr& any_level()
+		{
+			static const level_ptr instance = std::make_shared<std::atomic<level>>(level::unknown);
+			return instance;
+		}
+
+		//"db.pool.conn" -> "db.pool" -> "db" -> ""
+		inline std::string get_parent_name(const std::string& name)
+		{
+			const auto position = name.rfind('.');
+			return position == std::string::npos ? std::string{} : name.substr(0, position);
+		}
+
+		inline std::string trim(const std::string& str)
+		{
+			const auto begin = str.find_first_not_of(" \t\r");
+			if (begin == std::string::npos)
+				return {};
+			const auto end = str.find_last_not_of(" \t\r");
+			return str.substr(begin, end - begin + 1);
+		}
+	} //namespace details
+
+	inline std::optional<level> parse_level(const std::string& str)
+	{
+		for (const auto lvl : {level::unknown, level::trace, level::debug, level::info, level::warning, level::error, level::critical})
+			if (utils::to_string(lvl) == str)
+				return lvl;
+		return std::nullopt;
+	}
+
+	//Hierarchical thresholds of named loggers: "db.pool.conn" inherits the level of "db.pool", next of "db" and next of root ("").
+	//Loggers keep the effective level as an atomic which is updated on reconfiguration,
+	//so the check of level costs a single load.
+	class level_registry :
+		public utils::noncopyable
+	{
+	public:
+		using levels_t = std::map<std::string, level>;
+
+	public:
+		//The registry doesn't keep the level alive; a level of dropped loggers is released on the next update
+		level_ptr get_level(const std::string& name)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto& weak = cells[name];
+			auto cell = weak.lock();
+			if (cell == nullptr)
+			{
+				cell = std::make_shared<std::atomic<level>>(get_effective_level(name));
+				weak = cell;
+			}
+			return cell;
+		}
+
+		void set_level(const std::string& name, const level& lvl)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			configured[name] = lvl;
+			update();
+		}
+
+		void reset_level(const std::string& name)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			configured.erase(name);
+			update();
+		}
+
+		//Replaces all the configured levels at once
+		void set_levels(levels_t&& levels)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			configured = std::move(levels);
+			update();
+		}
+
+		//Lines "db.pool = debug"; "*" stands for root; '#' starts a comment.
+		//Throws std::invalid_argument on a malformed line and keeps the current levels then.
+		void load(std::istream& stream)
+		{
+			levels_t levels;
+			std::string line;
+			for (std::size_t number = 1; std::getline(stream, line); ++number)
+			{
+				line = details::trim(line.substr(0, line.find('#')));
+				if (line.empty())
+					continue;
+				const auto separator = line.find('=');
+				if (separator == std::string::npos)
+					throw std::invalid_argument("line " + std::to_string(number) + ": '=' is expected");
+				auto name = details::trim(line.substr(0, separator));
+				const auto lvl = parse_level(details::trim(line.substr(separator + 1)));
+				if (!lvl)
+					throw std::invalid_argument("line " + std::to_string(number) + ": unknown level");
+				levels[name == "*" ? std::string{} : std::move(name)] = *lvl;
+			}
+			set_levels(std::move(levels));
+		}
+
+	private:
+		//Should be called under mutex
+		level get_effective_level(std::string name) const
+		{
+			for (;;)
+			{
+				const auto iter = configured.find(name);
+				if (iter != configured.end())
+					return iter->second;
+				if (name.empty())
+					return level::unknown;
+				name = details::get_parent_name(name);
+			}
+		}
+
+		//Should be called under mutex
+		void update()
+		{
+			for (auto iter = cells.begin(); iter != cells.end(); )
+			{
+				if (const auto cell = iter->second.lock())
+				{
+					cell->store(get_effective_level(iter->first), std::memory_order_relaxed);
+					++iter;
+				}
+				else
+					iter = cells.erase(iter);
+			}
+		}
+
+	private:
+		std::mutex mutex;
+		levels_t configured;
+		std::map<std::string, std::weak_ptr<std::atomic<level>>> cells;
+	};
+
+	//Process-wide registry which is used by get_logger by default
+	inline level_registry& levels()
+	{
+		static level_registry instance;
+		return instance;
+	}
+} //namespace charivari_ltd::loggerpp
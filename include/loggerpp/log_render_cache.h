@@ -0,0 +1,417 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace charivari_ltd::loggerpp
+{
+	//Where records are rendered: by consumers on the dispatcher (or own) thread, or by logging thread.
+	//Rendering on producer unloads the dispatcher thread at the cost of latency of log call.
+	enum class serialization
+	{
+		on_consumer,
+		on_producer,
+	};
+
+namespace details
+{
+	template <typename format_t>
+	struct render_format_id
+	{
+		static inline const char id = 0;
+	};
+
+	//Rendered forms of one record by format: the first consumer of a format renders the record, the others reuse the text.
+	//Consumers may run on different threads (see run_own_thread), so a slot is claimed for a format by compare-exchange
+	//and its state tells if the text is ready; the forms are kept in the record, so the cache allocates nothing itself.
+	//A form may be rendered of other ones (see write_text_record); forms beyond slots_count are rendered each time.
+	class render_cache
+	{
+		static const std::size_t slots_count = 4;
+
+		enum state : int
+		{
+			empty,
+			rendering,
+			ready,
+		};
+
+		struct slot
+		{
+			std::atomic<const void*> format {nullptr};
+			std::atomic<int> current {empty};
+			std::string text;
+		};
+
+	public:
+		template <typename format_t, typename render_t>
+		const std::string& get(render_t&& render) const
+		{
+			const void* id = &render_format_id<format_t>::id;
+			for (auto& s : slots)
+			{
+				const void* format = s.format.load(std::memory_order_acquire);
+				if (format == nullptr && s.format.compare_exchange_strong(format, id, std::memory_order_acq_rel))
+					format = id;
+				if (format == id)
+					return get(s, render);
+			}
+			thread_local std::string uncached;
+			uncached = render();
+			return uncached;
+		}
+
+	private:
+		//A consumer which fails to render leaves the slot for the next one
+		template <typename render_t>
+		static const std::string& get(slot& s, render_t& render)
+		{
+			for (;;)
+			{
+				auto expected = s.current.load(std::memory_order_acquire);
+				if (expected == ready)
+					return s.text;
+				if (expected == empty && s.current.compare_exchange_strong(expected, rendering, std::memory_order_acquire))
+				{
+					try {
+						s.text = render();
+					} catch (...) {
+						s.current.store(empty, std::memory_order_release);
+						throw;
+					}
+					s.current.store(ready, std::memory_order_release);
+					return s.text;
+				}
+				std::this_thread::yield();
+			}
+		}
+
+	private:
+		mutable std::array<slot, slots_count> slots;
+	};
+
+	//Render cache of the record which the dispatcher passes to consumers right now; it serves traits which don't keep a cache in records.
+	//Consumers get the dispatched record by reference, so it's recognized by address; copies (e.g. queued by run_own_thread) are rendered each.
+	class dispatch_render_scope
+	{
+	public:
+		explicit dispatch_render_scope(const void* record) :
+			record(record),
+			previous(current())
+		{
+			current() = this;
+		}
+
+		dispatch_render_scope(const dispatch_render_scope&) = delete;
+		dispatch_render_scope& operator = (const dispatch_render_scope&) = delete;
+
+		~dispatch_render_scope()
+		{
+			current() = previous;
+		}
+
+		//A consumer may log to a synchronous dispatcher, so the scopes of the thread are nested
+		static const render_cache* find(const void* record)
+		{
+			for (auto scope = current(); scope != nullptr; scope = scope->previous)
+				if (scope->record == record)
+					return &scope->cache;
+			return nullptr;
+		}
+
+	private:
+		static dispatch_render_scope*& current()
+		{
+			thread_local dispatch_render_scope* instance = nullptr;
+			return instance;
+		}
+
+	private:
+		const void* const record;
+		dispatch_render_scope* const previous;
+		render_cache cache;
+	};
+
+	//Context tags of a logger follow the guaranteed tags in its records and are the same in each record,
+	//so sinks render them once per logger and format
+	struct context_cache
+	{
+		explicit context_cache(std::size_t count) :
+			count(count)
+		{}
+
+		const std::size_t count;
+		render_cache cache;
+	};
+
+	using context_ptr = std::shared_ptr<const context_cache>;
+
+	//Tags of a record with its render cache and context of logger; the handle still points to tags_t
+	template <typename tags_t>
+	struct cached_tags :
+		tags_t
+	{
+		cached_tags(tags_t&& tags, context_ptr context, bool with_cache) :
+			tags_t(std::move(tags)),
+			context(std::move(context))
+		{
+			if (with_cache)
+				cache.emplace();
+		}
+
+		std::optional<render_cache> cache;	//empty if records of the dispatcher have one text consumer
+		const context_ptr context;
+	};
+
+	//Deleter of the records made by make_cached_tags; it refers to the record, so the cache is found by std::get_deleter
+	template <typename tags_t>
+	struct cached_tags_deleter
+	{
+		void operator () (const tags_t*) const
+		{
+			delete record;
+		}
+
+		const cached_tags<tags_t>* record;
+	};
+
+	template <typename tags_t>
+	inline std::shared_ptr<const tags_t> make_cached_tags(tags_t&& tags, context_ptr context, bool with_cache)
+	{
+		const auto record = new cached_tags<tags_t>(std::move(tags), std::move(context), with_cache);
+		return std::shared_ptr<const tags_t>(record, cached_tags_deleter<tags_t>{record});
+	}
+
+	//nullptr for records made without cached_tags
+	template <typename tags_t>
+	inline const cached_tags<tags_t>* find_cached_tags(const std::shared_ptr<const tags_t>& tags)
+	{
+		const auto deleter = std::get_deleter<cached_tags_deleter<tags_t>>(tags);
+		return deleter == nullptr ? nullptr : deleter->record;
+	}
+
+	//Consumer which writes records through write_rendered. Dispatcher counts such subscriptions,
+	//and records get a render cache only if there are several of them (see dispatcher::is_render_shared).
+	template <typename consumer_t>
+	struct text_consumer
+	{
+		template <typename tags_handle_t>
+		void operator () (const tags_handle_t& tags_handle) const
+		{
+			consumer(tags_handle);
+		}
+
+		consumer_t consumer;
+	};
+
+	template <typename consumer_t>
+	inline auto make_text_consumer(consumer_t&& consumer)
+	{
+		return text_consumer<std::decay_t<consumer_t>>{std::forward<consumer_t>(consumer)};
+	}
+
+	template <typename consumer_t>
+	struct is_text_consumer : std::false_type {};
+
+	template <typename consumer_t>
+	struct is_text_consumer<text_consumer<consumer_t>> : std::true_type {};
+
+	//Wrappers of consumers (own thread, pool) stay text consumers
+	template <typename consumer_t, typename wrapper_t>
+	inline auto wrap_consumer(wrapper_t&& wrapper)
+	{
+		if constexpr (is_text_consumer<std::decay_t<consumer_t>>::value)
+			return make_text_consumer(std::forward<wrapper_t>(wrapper));
+		else
+			return std::forward<wrapper_t>(wrapper);
+	}
+
+	//Renders to ostream once per format
+	template <typename format_t, typename render_t>
+	inline const std::string& get_rendered(const render_cache& cache, render_t&& render)
+	{
+		return cache.template get<format_t>([&render] {
+			std::ostringstream text;
+			render(text);
+			return text.str();
+		});
+	}
+
+	template <typename traits_t, typename = void>
+	struct has_render_cache : std::false_type {};
+
+	template <typename traits_t>
+	struct has_render_cache<traits_t, std::void_t<decltype(traits_t::get_render_cache(std::declval<const typename traits_t::tags_handle_t&>()))>> : std::true_type {};
+
+	//The cache of record if traits keep it, the cache of the record being dispatched otherwise
+	template <typename traits_t>
+	inline const render_cache* get_render_cache(const typename traits_t::tags_handle_t& tags_handle)
+	{
+		if constexpr (has_render_cache<traits_t>::value)
+			if (const auto cache = traits_t::get_render_cache(tags_handle))
+				return cache;
+		return dispatch_render_scope::find(&tags_handle);
+	}
+
+	//Writes the record rendered by render(ostream&); the text is taken from the render cache if there is one
+	template <typename traits_t, typename format_t, typename render_t>
+	inline void write_rendered(std::ostream& out, const typename traits_t::tags_handle_t& tags_handle, render_t&& render)
+	{
+		if (const auto* cache = get_render_cache<traits_t>(tags_handle))
+			out << get_rendered<format_t>(*cache, render);
+		else
+			render(out);
+	}
+
+	template <typename traits_t, typename = void>
+	struct has_context : std::false_type {};
+
+	template <typename traits_t>
+	struct has_context<traits_t, std::void_t<decltype(traits_t::get_context(std::declval<const typename traits_t::tags_handle_t&>()))>> : std::true_type {};
+
+	template <typename traits_t>
+	inline const context_cache* get_context(const typename traits_t::tags_handle_t& tags_handle)
+	{
+		if constexpr (has_context<traits_t>::value)
+			return traits_t::get_context(tags_handle);
+		else
+			return nullptr;
+	}
+
+	//Context of logger with these tags; nullptr if traits don't keep it in records
+	template <typename traits_t>
+	inline context_ptr make_context(const typename traits_t::tags_t& tags)
+	{
+		if constexpr (has_context<traits_t>::value)
+			return tags.empty() ? nullptr : std::make_shared<const context_cache>(tags.size());
+		else
+			return nullptr;
+	}
+
+	//Context of a logger is made by its second record, so loggers which log once, e.g. temporaries
+	//of (root | tag).info(...), never allocate it. Copies make their own context.
+	class lazy_context
+	{
+		enum state : int
+		{
+			unused,
+			used,
+			making,
+			made,
+		};
+
+	public:
+		lazy_context() = default;
+
+		lazy_context(const lazy_context&)
+		{}
+
+		lazy_context& operator = (const lazy_context&)
+		{
+			context.reset();
+			current.store(unused, std::memory_order_relaxed);
+			return *this;
+		}
+
+		//nullptr until the context is made; records logged meanwhile are rendered without it
+		template <typename traits_t>
+		const context_ptr& get(const typename traits_t::tags_t& tags) const
+		{
+			static const context_ptr none;
+			if constexpr (!has_context<traits_t>::value)
+				return none;
+			else
+			{
+				auto expected = current.load(std::memory_order_acquire);
+				if (expected == made)
+					return context;
+				if (expected == unused && current.compare_exchange_strong(expected, used, std::memory_order_acquire))
+					return none;
+				if (expected == used && current.compare_exchange_strong(expected, making, std::memory_order_acquire))
+				{
+					context = make_context<traits_t>(tags);
+					current.store(made, std::memory_order_release);
+					return context;
+				}
+				return expected == made ? context : none;
+			}
+		}
+
+	private:
+		mutable std::atomic<int> current {unused};
+		mutable context_ptr context;
+	};
+
+	//render_shared is true if the record goes to several text consumers
+	template <typename traits_t>
+	inline auto make_tags_handle(typename traits_t::tags_t&& tags, const context_ptr& context, bool render_shared)
+	{
+		if constexpr (has_context<traits_t>::value)
+			return traits_t::make_tags_handle(std::move(tags), context, render_shared);
+		else
+			return traits_t::make_tags_handle(std::move(tags));
+	}
+
+	template <typename traits_t, typename = void>
+	struct serialization_of
+	{
+		static constexpr serialization value = serialization::on_consumer;
+	};
+
+	template <typename traits_t>
+	struct serialization_of<traits_t, std::void_t<decltype(traits_t::serialization_mode)>>
+	{
+		static constexpr serialization value = traits_t::serialization_mode;
+	};
+
+	//Called by logger on the logging thread before the record is pushed to dispatcher
+	template <typename traits_t>
+	inline void serialize_on_producer(const typename traits_t::tags_handle_t& tags_handle)
+	{
+		if constexpr (serialization_of<traits_t>::value == serialization::on_producer)
+			traits_t::serialize(tags_handle);
+	}
+}//namespace details
+} //namespace charivari_ltd::loggerpp
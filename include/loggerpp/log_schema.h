@@ -0,0 +1,243 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "logger.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace charivari_ltd::loggerpp
+{
+	template <typename class_t, typename type_t>
+	struct schema_field
+	{
+		const char* key;
+		type_t class_t::* member;
+	};
+
+	template <typename class_t, typename type_t>
+	constexpr schema_field<class_t, type_t> field(const char* key, type_t class_t::* member)
+	{
+		return {key, member};
+	}
+
+	//Calls fn(key, value) for each field declared by schema_t::fields()
+	template <typename schema_t, typename fn_t>
+	inline void for_each_field(const schema_t& schema, fn_t&& fn)
+	{
+		std::apply([&schema, &fn] (const auto& ... fields) {
+			(fn(fields.key, schema.*(fields.member)), ...);
+		}, schema_t::fields());
+	}
+
+	template <typename schema_t>
+	constexpr std::size_t get_fields_count()
+	{
+		return std::tuple_size_v<decltype(schema_t::fields())>;
+	}
+
+namespace details
+{
+	//Tags of a record and its context as plain members; the tags are still a deque for consumers which don't know the schema
+	template <typename schema_t, typename tag_t>
+	struct schema_tags :
+		std::deque<tag_t>
+	{
+		using std::deque<tag_t>::deque;
+
+		schema_t schema;
+	};
+
+	template <typename tags_t, typename = void>
+	struct has_schema : std::false_type {};
+
+	template <typename tags_t>
+	struct has_schema<tags_t, std::void_t<decltype(std::declval<const tags_t&>().schema)>> : std::true_type {};
+
+	//Fields of arithmetic types are stored as set_schema_tag reads them: signed as int64, unsigned as uint64, floating as double
+	template <typename value_t, typename field_t>
+	inline value_t to_schema_value(const field_t& value)
+	{
+		if constexpr (std::is_same_v<field_t, bool>)
+			return value_t{utils::bool_t{value}};
+		else if constexpr (std::is_integral_v<field_t> && std::is_signed_v<field_t>)
+			return value_t{static_cast<std::int64_t>(value)};
+		else if constexpr (std::is_integral_v<field_t>)
+			return value_t{static_cast<std::uint64_t>(value)};
+		else if constexpr (std::is_floating_point_v<field_t>)
+			return value_t{static_cast<double>(value)};
+		else
+			return value_t{value};
+	}
+
+	//Calls fn(key, value) for each field of schema converted to value_t; nothing for tags without schema
+	template <typename value_t, typename tags_t, typename fn_t>
+	inline void for_each_schema_tag(const tags_t& tags, fn_t&& fn)
+	{
+		if constexpr (has_schema<tags_t>::value)
+			for_each_field(tags.schema, [&fn] (const char* key, const auto& value) {
+				fn(key, to_schema_value<value_t>(value));
+			});
+	}
+
+	//Restores the field of schema written by for_each_schema_tag; false if tags have no field named key
+	template <typename tags_t, typename value_t>
+	inline bool set_schema_tag(tags_t& tags, const std::string& key, const value_t& value)
+	{
+		if constexpr (has_schema<tags_t>::value)
+		{
+			bool found = false;
+			std::apply([&tags, &key, &value, &found] (const auto& ... fields) {
+				const auto set = [&key, &value, &found] (const char* name, auto& member) {
+					if (found || key != name)
+						return;
+					found = true;
+					std::visit([&member] (const auto& v) {
+						//see to_schema_value
+						using field_t = std::decay_t<decltype(member)>;
+						using source_t = std::decay_t<decltype(v)>;
+						if constexpr (std::is_same_v<field_t, bool>)
+						{
+							if constexpr (std::is_same_v<source_t, utils::bool_t>)
+								member = static_cast<bool>(v);
+						}
+						else if constexpr (std::is_same_v<source_t, field_t> || (std::is_arithmetic_v<source_t> && std::is_arithmetic_v<field_t>))
+							member = static_cast<field_t>(v);
+					}, value);
+				};
+				(set(fields.key, tags.schema.*(fields.member)), ...);
+			}, decltype(tags.schema)::fields());
+			return found;
+		}
+		else
+			return false;
+	}
+
+	template <typename tags_t>
+	constexpr std::size_t get_schema_tags_count()
+	{
+		if constexpr (has_schema<tags_t>::value)
+			return get_fields_count<decltype(tags_t::schema)>();
+		else
+			return 0;
+	}
+}//namespace details
+
+	//Context tags are declared as struct with typed fields and static constexpr fields(), e.g.
+	//	struct request_context
+	//	{
+	//		std::string request_id;
+	//		std::int64_t entity = 0;
+	//		static constexpr auto fields()
+	//		{
+	//			return std::make_tuple(loggerpp::field("request_id", &request_context::request_id), loggerpp::field("entity", &request_context::entity));
+	//		}
+	//	};
+	//Records keep the context as plain members: get_schema(tags).entity costs nothing unlike get_tag<T>(tags, "entity").
+	template <typename _schema_t>
+	struct schema_log_traits :
+		default_log_traits
+	{
+		using schema_t = _schema_t;
+		using tags_t = details::schema_tags<schema_t, tag_t>;
+		using tags_handle_t = tags_t;
+
+		static inline tags_t extend_back(tags_t&& tags, tags_t&& t)
+		{
+			for (auto&& item : t)
+				tags.push_back(std::move(item));
+			return std::move(tags);
+		}
+
+		static inline tags_t extend_front(tags_t&& tags, tags_t&& t)
+		{
+			for (auto&& item : t)
+				tags.push_front(std::move(item));
+			return std::move(tags);
+		}
+
+		static inline tags_handle_t make_tags_handle(tags_t&& tags)
+		{
+			return std::move(tags);
+		}
+
+		static inline const tags_t& extract_tags(const tags_handle_t& tags)
+		{
+			return tags;
+		}
+
+		static inline auto begin_guaratee_tag(const tags_t& tags)
+		{
+			return tags.begin();
+		}
+		static inline auto end_guaratee_tag(const tags_t& tags)
+		{
+			const auto index = std::min(constants::index_guaratee_size, tags.size());
+			return tags.begin() + index;
+		}
+		static inline auto begin_unguaratee_tag(const tags_t& tags)
+		{
+			const auto index = std::min(constants::index_guaratee_size, tags.size());
+			return tags.begin() + index;
+		}
+		static inline auto end_unguaratee_tag(const tags_t& tags)
+		{
+			return tags.end();
+		}
+	};
+
+	template <typename schema_t, typename tag_t>
+	inline const schema_t& get_schema(const details::schema_tags<schema_t, tag_t>& tags)
+	{
+		return tags.schema;
+	}
+
+	//Logger with the context replaced by schema; other tags are kept.
+	//schema_t is deduced, so braced lists of tags still go to extend_logger of tags.
+	template <typename traits_t, typename schema_t, typename = std::enable_if_t<std::is_same_v<schema_t, typename traits_t::schema_t>>>
+	inline logger_base<traits_t> extend_logger(const logger_base<traits_t>& ref, const schema_t& schema)
+	{
+		auto tags = ref.get_tags();
+		tags.schema = schema;
+		return {ref.get_dispatcher(), std::move(tags), ref.get_threshold()};
+	}
+
+	template <typename schema_t>
+	using schema_logger = logger_base<schema_log_traits<schema_t>>;
+} //namespace charivari_ltd::loggerpp
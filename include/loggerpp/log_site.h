@@ -0,0 +1,177 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "log_level.h"
+
+#include <utils/noncopyable.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//Logs with static descriptor of the call site: format, level, file, line and function are registered once,
+//records carry "site" tag with the site id instead of message and the arguments as tags.
+//LOGGERPP_LOG(root, loggerpp::level::info, "connected to {}:{}", host, port);
+//The count of arguments is taken from the type of a never called lambda, so the arguments aren't evaluated by registration.
+//The level is a part of the descriptor, so it must be a constant expression: a runtime level would be frozen by the first call.
+#define LOGGERPP_LOG(logger, lvl, ...) \
+	do { \
+		const auto loggerpp_count_args = [&] { return ::charivari_ltd::loggerpp::details::count_site_args(__VA_ARGS__); }; \
+		constexpr ::charivari_ltd::loggerpp::level loggerpp_level = lvl; \
+		static auto& loggerpp_site = ::charivari_ltd::loggerpp::sites().add(loggerpp_level, LOGGERPP_EXPAND(LOGGERPP_SITE_FORMAT(__VA_ARGS__, 0)), __FILE__, __LINE__, __func__, \
+			decltype(loggerpp_count_args())::value); \
+		(logger).log(loggerpp_site, __VA_ARGS__); \
+	} while (false)
+
+#define LOGGERPP_EXPAND(x) x
+#define LOGGERPP_SITE_FORMAT(format, ...) format
+
+namespace charivari_ltd::loggerpp
+{
+	struct log_site
+	{
+		std::uint64_t id;
+		level lvl;
+		const char* format;
+		const char* file;
+		unsigned line;
+		const char* function;
+		std::size_t args_count;		//the last tags of record are the arguments
+	};
+
+	namespace details
+	{
+		//The first argument is format
+		template <typename format_t, typename ... args_t>
+		std::integral_constant<std::size_t, sizeof...(args_t)> count_site_args(format_t&&, args_t&& ...)
+		{
+			return {};
+		}
+
+		//Keys of argument tags "0", "1", ... are made once per count of arguments
+		template <std::size_t count>
+		const std::array<std::string, count>& get_site_arg_keys()
+		{
+			static const auto keys = [] {
+				std::array<std::string, count> result;
+				for (std::size_t index = 0; index < count; ++index)
+					result[index] = std::to_string(index);
+				return result;
+			}();
+			return keys;
+		}
+	}//namespace details
+
+	//Descriptors are never removed, so references to them stay valid.
+	//find doesn't lock: the table of descriptors is replaced by a bigger copy on growth and the old ones are kept.
+	class site_registry :
+		public utils::noncopyable
+	{
+		struct table
+		{
+			explicit table(std::size_t capacity) :
+				capacity(capacity),
+				items(new const log_site* [capacity])
+			{}
+
+			const std::size_t capacity;
+			std::unique_ptr<const log_site* []> items;
+		};
+
+	public:
+		log_site& add(const level& lvl, const char* format, const char* file, unsigned line, const char* function, std::size_t args_count = 0)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto& site = sites.emplace_back();
+			site.id = sites.size() - 1;
+			site.lvl = lvl;
+			site.format = format;
+			site.file = file;
+			site.line = line;
+			site.function = function;
+			site.args_count = args_count;
+
+			auto current = tables.empty() ? nullptr : &tables.back();
+			if (current == nullptr || current->capacity == site.id)
+			{
+				auto& grown = tables.emplace_back(current == nullptr ? 64 : current->capacity * 2);
+				if (current != nullptr)
+					std::copy(current->items.get(), current->items.get() + current->capacity, grown.items.get());
+				current = &grown;
+				published.store(current, std::memory_order_release);
+			}
+			current->items[site.id] = &site;
+			count.store(sites.size(), std::memory_order_release);
+			return site;
+		}
+
+		//nullptr for unknown id
+		const log_site* find(std::uint64_t id) const
+		{
+			if (id >= count.load(std::memory_order_acquire))
+				return nullptr;
+			return published.load(std::memory_order_acquire)->items[id];
+		}
+
+		//Sinks may write descriptors once and records with ids only
+		std::vector<const log_site*> get_sites() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			std::vector<const log_site*> result;
+			for (const auto& site : sites)
+				result.push_back(&site);
+			return result;
+		}
+
+	private:
+		mutable std::mutex mutex;
+		std::deque<log_site> sites;
+		std::deque<table> tables;
+		std::atomic<const table*> published {nullptr};
+		std::atomic<std::size_t> count {0};
+	};
+
+	inline site_registry& sites()
+	{
+		static site_registry instance;
+		return instance;
+	}
+} //namespace charivari_ltd::loggerpp
@@ -0,0 +1,195 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "log_level.h"
+
+#include <utils/noncopyable.h>
+#include <utils/utils.h>
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace charivari_ltd::loggerpp
+{
+	namespace details
+	{
+		//Reused by all the streams of the thread; a nested stream gets its own buffer
+		struct stream_buffer
+		{
+			std::string data;
+			bool busy = false;
+		};
+
+		inline stream_buffer& get_stream_buffer()
+		{
+			thread_local stream_buffer instance;
+			return instance;
+		}
+
+		template <typename type_t>
+		constexpr bool is_wide_char_v = std::is_same_v<type_t, wchar_t> || std::is_same_v<type_t, char16_t> || std::is_same_v<type_t, char32_t>;
+
+		//Surrogates of UTF-16 are not combined; each code unit is encoded by itself
+		inline void append_utf8(std::string& out, std::uint32_t code)
+		{
+			if (code < 0x80)
+				out.push_back(static_cast<char>(code));
+			else if (code < 0x800)
+			{
+				out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+				out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			else if (code < 0x10000)
+			{
+				out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+				out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			else
+			{
+				out.push_back(static_cast<char>(0xF0 | ((code >> 18) & 0x07)));
+				out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+		}
+	} //namespace details
+
+	//logger.info() << "x=" << x;
+	//The message is collected in thread-local buffer and logged at the end of statement.
+	//Nothing is formatted if the level is disabled.
+	template <typename logger_t>
+	class record_stream :
+		public utils::noncopyable
+	{
+	public:
+		record_stream(const logger_t* logger, const level& lvl) :
+			logger(logger),
+			lvl(lvl),
+			exceptions(std::uncaught_exceptions())
+		{
+			if (logger == nullptr)
+				return;
+			auto& shared = details::get_stream_buffer();
+			if (!shared.busy)
+			{
+				shared.busy = true;
+				buffer = &shared.data;
+			}
+		}
+
+		//A record is not logged when the statement is interrupted by exception
+		~record_stream() noexcept(false)
+		{
+			if (logger == nullptr)
+				return;
+			auto& shared = details::get_stream_buffer();
+			const bool own_shared = buffer == &shared.data;
+			//The shared buffer keeps its capacity for the next statement, so the record gets a copy of the exact size;
+			//the buffer of a nested stream is not reused and is moved to the record
+			std::string message = own_shared ? std::string(buffer->data(), buffer->size()) : std::move(*buffer);
+			buffer->clear();
+			if (own_shared)
+				shared.busy = false;
+			if (std::uncaught_exceptions() == exceptions)
+				logger->log(typename logger_t::tags_t{}, lvl, std::move(message));
+		}
+
+	public:
+		template <typename arg_t>
+		record_stream& operator << (const arg_t& arg)
+		{
+			if (logger != nullptr)
+				append(arg);
+			return *this;
+		}
+
+	private:
+		void append(const char* str)
+		{
+			buffer->append(str);
+		}
+
+		void append(char ch)
+		{
+			buffer->push_back(ch);
+		}
+
+		void append(bool value)
+		{
+			buffer->append(value ? "true" : "false");
+		}
+
+		template <typename arg_t>
+		void append(const arg_t& arg)
+		{
+			if constexpr (std::is_convertible_v<const arg_t&, std::string_view>)
+				buffer->append(std::string_view(arg));
+			else if constexpr (details::is_wide_char_v<arg_t>)
+				details::append_utf8(*buffer, static_cast<std::uint32_t>(arg));
+			else if constexpr (std::is_integral_v<arg_t>)
+			{
+				std::array<char, 32> chars;
+				const auto result = std::to_chars(chars.data(), chars.data() + chars.size(), arg);
+				buffer->append(chars.data(), result.ptr);
+			}
+			else if constexpr (std::is_floating_point_v<arg_t>)
+			{
+				//fixed with 6 digits after point as utils::to_string of default_formatter
+				std::array<char, 64> chars;
+				const auto result = std::to_chars(chars.data(), chars.data() + chars.size(), static_cast<double>(arg), std::chars_format::fixed, 6);
+				if (result.ec == std::errc{})
+					buffer->append(chars.data(), result.ptr);
+				else
+					buffer->append(utils::to_string(static_cast<double>(arg)));
+			}
+			else
+				buffer->append(utils::to_string(arg));
+		}
+
+	private:
+		const logger_t* logger;
+		const level lvl;
+		const int exceptions;
+		std::string own;
+		std::string* buffer = &own;
+	};
+} //namespace charivari_ltd::loggerpp
@@ -0,0 +1,129 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include <cerrno>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace charivari_ltd::loggerpp
+{
+	//Applied by logger threads to themselves at start. Only Linux is supported for now, other platforms ignore it.
+	struct thread_options
+	{
+		std::string name;					//visible in top/perf; truncated to 15 chars
+		std::vector<std::size_t> affinity;	//indexes of allowed CPUs; empty means any
+		std::optional<int> nice;
+		std::optional<int> policy;			//SCHED_OTHER, SCHED_FIFO, SCHED_RR, SCHED_BATCH, SCHED_IDLE
+		int priority = 0;					//sched_priority for policy
+		std::function<void ()> on_start;	//any other configuration
+		std::function<void (const std::system_error&)> on_error;	//a setting is not applied; std::cerr if empty
+	};
+
+	namespace details
+	{
+		inline void report_thread_option_error(const thread_options& options, int error, const char* what)
+		{
+			const std::system_error e(error, std::generic_category(), what);
+			if (options.on_error)
+				options.on_error(e);
+			else
+				std::cerr << "loggerpp: thread option is not applied: " << e.what() << std::endl;
+		}
+	}//namespace details
+
+	//The settings are hints: one which can't be applied (e.g. EPERM for SCHED_FIFO) is reported by on_error
+	//and the thread keeps running with the rest. Exceptions of on_start are passed to the caller.
+	inline void apply_thread_options(const thread_options& options)
+	{
+#if defined(__linux__)
+		if (!options.name.empty())
+		{
+			const auto name = options.name.substr(0, 15);
+			if (const auto error = ::pthread_setname_np(::pthread_self(), name.c_str()))
+				details::report_thread_option_error(options, error, "pthread_setname_np");
+		}
+
+		if (!options.affinity.empty())
+		{
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			bool any = false;
+			for (const auto cpu : options.affinity)
+			{
+				//CPU_SET doesn't check the index
+				if (cpu >= CPU_SETSIZE)
+				{
+					details::report_thread_option_error(options, EINVAL, ("CPU_SET: cpu " + std::to_string(cpu) + " is out of range").c_str());
+					continue;
+				}
+				CPU_SET(cpu, &set);
+				any = true;
+			}
+			if (any)
+				if (const auto error = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set))
+					details::report_thread_option_error(options, error, "pthread_setaffinity_np");
+		}
+
+		if (options.policy)
+		{
+			sched_param param {};
+			param.sched_priority = options.priority;
+			if (const auto error = ::pthread_setschedparam(::pthread_self(), *options.policy, &param))
+				details::report_thread_option_error(options, error, "pthread_setschedparam");
+		}
+
+		if (options.nice)
+		{
+			const auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+			if (::setpriority(PRIO_PROCESS, tid, *options.nice) != 0)
+				details::report_thread_option_error(options, errno, "setpriority");
+		}
+#endif
+		if (options.on_start)
+			options.on_start();
+	}
+} //namespace charivari_ltd::loggerpp
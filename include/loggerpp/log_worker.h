@@ -0,0 +1,293 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "log_thread.h"
+
+#include <utils/noncopyable.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace charivari_ltd::loggerpp
+{
+	enum class wait_strategy
+	{
+		busy_spin,		//never sleeps; for a thread pinned to an isolated core
+		spin_yield,		//spins for a while, next yields time slice
+		blocking,		//sleeps on condition variable
+		adaptive,		//spins, yields and next sleeps on condition variable
+	};
+
+	struct worker_options
+	{
+		wait_strategy wait = wait_strategy::blocking;
+		std::size_t spin_count = 4000;
+		std::size_t yield_count = 100;
+		//Time to collect more tasks after wakeup; reduces count of wakeups for batch jobs
+		std::chrono::microseconds wakeup_delay {0};
+		thread_options thread;
+	};
+
+	namespace details
+	{
+		inline void cpu_relax()
+		{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+			_mm_pause();
+#endif
+		}
+	}//namespace details
+
+	//Single thread task queue with configurable idle behaviour.
+	//Producer wakes the thread up only when it sleeps on empty queue.
+	class worker :
+		public utils::noncopyable
+	{
+	public:
+		using task_t = std::function<void ()>;
+		using exception_handler_t = std::function<void (std::exception_ptr)>;
+
+	public:
+		explicit worker(exception_handler_t&& handler, const worker_options& options = {}) :
+			exception_handler(std::move(handler)),
+			options(options),
+			thread([this] {
+				run();
+			}),
+			thread_id(thread.get_id())
+		{}
+
+		//Executes all the pushed tasks before return
+		~worker()
+		{
+			stop();
+			if (thread.joinable())
+				thread.join();
+		}
+
+	public:
+		//Tasks pushed after the thread is finished are executed on the pushing thread one by one
+		void push(task_t&& task)
+		{
+			bool notify = false;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				if (finished)
+				{
+					lock.unlock();
+					return execute_inline(task);
+				}
+				tasks.push_back(std::move(task));
+				has_tasks.store(true, std::memory_order_release);
+				notify = sleeping;
+				sleeping = false;
+			}
+			if (notify)
+				wakeup.notify_one();
+		}
+
+		//The thread executes the pushed tasks and finishes without waiting for new ones; it's joined by destructor
+		void stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopped = true;
+			}
+			wakeup.notify_one();
+		}
+
+		//Stops the thread and waits until the pushed tasks are executed; does nothing more if called by a task of the worker
+		void join()
+		{
+			stop();
+			if (!is_current() && thread.joinable())
+				thread.join();
+		}
+
+		//True if called by a task of the worker
+		bool is_current() const
+		{
+			return std::this_thread::get_id() == thread_id;
+		}
+
+	private:
+		void execute_inline(task_t& task)
+		{
+			std::lock_guard<std::recursive_mutex> lock(inline_mutex);
+			try {
+				task();
+			} catch (...) {
+				exception_handler(std::current_exception());
+			}
+		}
+
+		void run()
+		{
+			try {
+				apply_thread_options(options.thread);
+			} catch (...) {
+				exception_handler(std::current_exception());
+			}
+
+			std::deque<task_t> batch;
+			for (;;)
+			{
+				wait();
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (tasks.empty() && stopped)
+					{
+						finished = true;
+						return;
+					}
+					batch.swap(tasks);
+					has_tasks.store(false, std::memory_order_relaxed);
+				}
+				for (auto& task : batch)
+				{
+					try {
+						task();
+					} catch (...) {
+						exception_handler(std::current_exception());
+					}
+				}
+				batch.clear();
+			}
+		}
+
+		void wait()
+		{
+			switch (options.wait)
+			{
+				case wait_strategy::busy_spin:
+					while (!ready())
+						details::cpu_relax();
+					return;
+				case wait_strategy::spin_yield:
+					if (spin())
+						return;
+					while (!ready())
+						std::this_thread::yield();
+					return;
+				case wait_strategy::blocking:
+					return block();
+				case wait_strategy::adaptive:
+					if (spin() || yield())
+						return;
+					return block();
+			}
+		}
+
+		bool ready() const
+		{
+			return has_tasks.load(std::memory_order_acquire) || stopped.load(std::memory_order_acquire);
+		}
+
+		bool spin() const
+		{
+			for (std::size_t index = 0; index < options.spin_count; ++index)
+			{
+				if (has_tasks.load(std::memory_order_acquire))
+					return true;
+				details::cpu_relax();
+			}
+			return false;
+		}
+
+		bool yield() const
+		{
+			for (std::size_t index = 0; index < options.yield_count; ++index)
+			{
+				if (has_tasks.load(std::memory_order_acquire))
+					return true;
+				std::this_thread::yield();
+			}
+			return false;
+		}
+
+		void block()
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				if (!tasks.empty() || stopped)
+					return;
+				sleeping = true;
+				wakeup.wait(lock, [this] {
+					return !tasks.empty() || stopped;
+				});
+				sleeping = false;
+			}
+			if (options.wakeup_delay.count() > 0)
+				std::this_thread::sleep_for(options.wakeup_delay);
+		}
+
+	private:
+		exception_handler_t exception_handler;
+		const worker_options options;
+
+		std::mutex mutex;
+		std::condition_variable wakeup;
+		std::deque<task_t> tasks;
+		std::atomic_bool has_tasks {false};
+		std::atomic_bool stopped {false};
+		bool sleeping = false;
+		bool finished = false;
+		std::recursive_mutex inline_mutex;
+
+		std::thread thread;
+		const std::thread::id thread_id;
+	};
+
+	//Process-wide worker for dispatchers created with dispatcher_options::shared_worker.
+	//It is started on first use; exceptions of the tasks are expected to be handled by the tasks themselves.
+	inline std::shared_ptr<worker> shared_worker()
+	{
+		static const auto instance = std::make_shared<worker>([] (std::exception_ptr ptr) {
+			std::rethrow_exception(ptr);
+		});
+		return instance;
+	}
+} //namespace charivari_ltd::loggerpp
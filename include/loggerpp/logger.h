@@ -35,6 +35,7 @@
 
 #include "log_base.h"
 #include "log_formatter.h"
+#include "log_render_cache.h"
 
 #include <utils/utils.h>
 #include <utils/bool_t.h>
@@ -48,6 +49,7 @@ namespace loggerpp
 	struct default_log_traits
 	{
 		using formatter_t = default_formatter;
+		using metrics_t = no_metrics;
 		using key_t = std::variant<std::string, std::wstring>;
 		using value_t = std::variant<nullptr_t, utils::bool_t, std::int64_t, std::uint64_t, double, std::string, std::wstring, level, std::chrono::system_clock::time_point>;
 
@@ -60,6 +62,11 @@ namespace loggerpp
 		using tags_t = std::deque<tag_t>;
 		using tags_handle_t = tags_t;
 
+		static inline dispatcher_options get_dispatcher_options()
+		{
+			return {};
+		}
+
 		static inline tags_t extend_back(tags_t&& tags, tags_t&& t)
 		{
 			for (auto&& item : t)
@@ -104,6 +111,24 @@ namespace loggerpp
 		}
 	};
 
+	//Consumers are called on the thread which logs; for single-threaded tools
+	struct sync_log_traits :
+		default_log_traits
+	{
+		static inline dispatcher_options get_dispatcher_options()
+		{
+			dispatcher_options options;
+			options.mode = dispatch_mode::synchronous;
+			return options;
+		}
+	};
+
+	//Dispatcher collects counters and histograms; see dispatcher::get_metrics
+	struct metrics_log_traits :
+		default_log_traits
+	{
+		using metrics_t = atomic_metrics;
+	};
 
 	template<typename tags_t>
 	inline void check_guarantee_size(const tags_t& tags)
@@ -126,17 +151,50 @@ namespace loggerpp
 		return std::get<level>(tags[constants::index_level].value);
 	}
 
+	namespace details
+	{
+		template<typename string_t, typename tags_t>
+		string_t render_site_message(const tags_t& tags, std::uint64_t id);
+	} //namespace details
+
+	//Site id of a record of LOGGERPP_LOG: its message is replaced by "site" tag; nullptr for other records
+	template<typename tags_t>
+	inline const std::uint64_t* get_site_id(const tags_t& tags)
+	{
+		if (tags.size() < constants::index_guaratee_size)
+			return nullptr;
+		const auto& tag = tags[constants::index_message];
+		const auto key = std::get_if<std::string>(&tag.key);
+		if (key == nullptr || *key != constants::key_site)
+			return nullptr;
+		return std::get_if<std::uint64_t>(&tag.value);
+	}
+
+	//Records of LOGGERPP_LOG are rendered from site format and argument tags
 	template<typename tags_t>
 	inline std::string get_message(const tags_t& tags)
 	{
 		check_guarantee_size(tags);
+		if (const auto id = get_site_id(tags))
+			return details::render_site_message<std::string>(tags, *id);
 		return std::get<std::string>(tags[constants::index_message].value);
 	}
 
+	//Count of the last tags which are arguments of LOGGERPP_LOG; 0 for other records
+	template<typename tags_t>
+	inline std::size_t get_site_args_count(const tags_t& tags)
+	{
+		const auto id = get_site_id(tags);
+		const auto site = id != nullptr ? sites().find(*id) : nullptr;
+		return site != nullptr ? std::min(site->args_count, tags.size() - constants::index_guaratee_size) : 0;
+	}
+
 	template<typename tags_t>
 	inline std::wstring get_wmessage(const tags_t& tags)
 	{
 		check_guarantee_size(tags);
+		if (const auto id = get_site_id(tags))
+			return details::render_site_message<std::wstring>(tags, *id);
 		return std::get<std::wstring>(tags[constants::index_message].value);
 	}
 
@@ -165,6 +223,47 @@ namespace loggerpp
 		}, value);
 	}
 
+	namespace details
+	{
+		template<typename string_t, typename value_t>
+		string_t to_site_arg_string(const value_t& value)
+		{
+			if constexpr (std::is_same_v<string_t, std::wstring>)
+				return to_wstring(value);
+			else
+				return to_string(value);
+		}
+
+		//Same placeholders as default_formatter; the format is widened by chars for std::wstring
+		template<typename string_t, typename tags_t>
+		string_t render_site_message(const tags_t& tags, std::uint64_t id)
+		{
+			const auto site = sites().find(id);
+			if (site == nullptr)
+			{
+				const auto unknown = "unknown site " + std::to_string(id);
+				return string_t(unknown.begin(), unknown.end());
+			}
+
+			const std::string_view format(site->format);
+			const std::string_view delim("{}");
+			auto arg = tags.end() - get_site_args_count(tags);
+			string_t out;
+			std::size_t position = 0;
+			for (; arg != tags.end(); ++arg)
+			{
+				const auto next = format.find(delim, position);
+				if (next == std::string_view::npos)
+					break;
+				out.append(format.begin() + position, format.begin() + next);
+				out.append(to_site_arg_string<string_t>(arg->value));
+				position = next + delim.size();
+			}
+			out.append(format.begin() + position, format.end());
+			return out;
+		}
+	} //namespace details
+
 	template<typename tags_t>
 	inline auto get_vtag(const tags_t& tags, const std::string& key)
 	{
@@ -197,22 +296,51 @@ namespace loggerpp
 		return std::optional<type_t>{};
 	}
 
+	namespace details
+	{
+		struct text_head_format {};
+
+		//Guaranteed tags separated by tab: the head is the same for console and file records, so it is rendered once per record
+		template <typename traits_t>
+		inline void write_text_head(std::ostream& out, const typename traits_t::tags_t& tags, const render_cache* cache = nullptr)
+		{
+			const auto render = [&tags] (std::ostream& text) {
+				for (auto iter = traits_t::begin_guaratee_tag(tags); iter != traits_t::end_guaratee_tag(tags); ++iter)
+				{
+					if (iter != traits_t::begin_guaratee_tag(tags))
+						text << '\t';
+
+					if (static_cast<std::size_t>(iter - traits_t::begin_guaratee_tag(tags)) == constants::index_message && get_site_id(tags) != nullptr)
+						text << get_message(tags);
+					else
+						text << to_string(iter->value);
+				}
+			};
+			if (cache != nullptr)
+				out << get_rendered<text_head_format>(*cache, render);
+			else
+				render(out);
+		}
+	}//namespace details
+
 	template <typename traits_t>
 	inline void base_default_consumer(const typename traits_t::tags_handle_t& tags_handle)
 	{
-		const auto& tags = traits_t::extract_tags(tags_handle);
-		std::cout
-			<< utils::to_string(get_time(tags)) << '\t'
-			<< utils::to_string(get_level(tags)) << '\t'
-			<< get_message(tags) << std::endl;
+		details::write_text_head<traits_t>(std::cout, traits_t::extract_tags(tags_handle), details::get_render_cache<traits_t>(tags_handle));
+		std::cout << std::endl;
 	}
 
 	inline void default_consumer(const default_log_traits::tags_handle_t& tags_handle)
 	{
 		base_default_consumer<default_log_traits>(tags_handle);
 	}
+
+	//Text consumers are counted by dispatcher to decide if records are worth a render cache
+	inline const auto default_text_consumer = details::make_text_consumer(&default_consumer);
 } //namespace loggerpp
 
 	using logger = loggerpp::logger_base<loggerpp::default_log_traits>;
+	using sync_logger = loggerpp::logger_base<loggerpp::sync_log_traits>;
+	using metrics_logger = loggerpp::logger_base<loggerpp::metrics_log_traits>;
 } //namespace charivari_ltd
 
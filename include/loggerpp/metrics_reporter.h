@@ -0,0 +1,127 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "logger.h"
+
+#include <utils/noncopyable.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace charivari_ltd::loggerpp
+{
+	namespace constants
+	{
+		static constexpr const char metrics_message[] = "loggerpp metrics";
+	} //namespace constants
+
+	template <typename traits_t>
+	inline void log_metrics(const logger_base<traits_t>& ref, const level& lvl = level::info)
+	{
+		const auto metrics = ref.get_dispatcher()->get_metrics();
+		typename traits_t::tags_t tags {
+			{"pushed", std::uint64_t{metrics.pushed}},
+			{"dispatched", std::uint64_t{metrics.dispatched}},
+			{"queue_depth", std::uint64_t{metrics.queue_depth}},
+			{"queue_depth_high_water", std::uint64_t{metrics.queue_depth_high_water}},
+			{"exceptions", std::uint64_t{metrics.exceptions}},
+			{"dropped", std::uint64_t{metrics.dropped}},
+			{"undelivered", std::uint64_t{metrics.undelivered}},
+			{"push_to_dispatch_p50_ns", metrics.push_to_dispatch.percentile(0.5)},
+			{"push_to_dispatch_p99_ns", metrics.push_to_dispatch.percentile(0.99)},
+			{"push_to_dispatch_max_ns", std::uint64_t{metrics.push_to_dispatch.max}},
+			{"consumer_call_p50_ns", metrics.consumer_call.percentile(0.5)},
+			{"consumer_call_p99_ns", metrics.consumer_call.percentile(0.99)},
+			{"consumer_call_max_ns", std::uint64_t{metrics.consumer_call.max}},
+		};
+		for (const auto& consumer : metrics.consumers)
+		{
+			const auto prefix = "consumer_" + std::to_string(consumer.id);
+			tags.push_back({prefix + "_call_p50_ns", consumer.call.percentile(0.5)});
+			tags.push_back({prefix + "_call_p99_ns", consumer.call.percentile(0.99)});
+			tags.push_back({prefix + "_call_max_ns", std::uint64_t{consumer.call.max}});
+		}
+		ref.log(lvl, std::move(tags), constants::metrics_message);
+	}
+
+	//Logs metrics of the dispatcher periodically from own thread
+	template <typename logger_t>
+	class metrics_reporter :
+		public utils::noncopyable
+	{
+	public:
+		metrics_reporter(const logger_t& ref, std::chrono::milliseconds period, const level& lvl = level::info) :
+			target(extend_logger(ref, {})),
+			thread([this, period, lvl] {
+				run(period, lvl);
+			})
+		{}
+
+		~metrics_reporter()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopped = true;
+			}
+			wakeup.notify_one();
+			thread.join();
+		}
+
+	private:
+		//The lock is released while logging, so the destructor doesn't wait for consumers
+		void run(std::chrono::milliseconds period, const level& lvl)
+		{
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					if (wakeup.wait_for(lock, period, [this] { return stopped; }))
+						return;
+				}
+				log_metrics(target, lvl);
+			}
+		}
+
+	private:
+		logger_t target;
+		std::mutex mutex;
+		std::condition_variable wakeup;
+		bool stopped = false;
+		std::thread thread;
+	};
+} //namespace charivari_ltd::loggerpp
@@ -0,0 +1,360 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "logger.h"
+#include "log_schema.h"
+#include "binary_log_format.h"
+
+#include <utils/noncopyable.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace charivari_ltd::loggerpp
+{
+	struct recent_log_options
+	{
+		std::size_t chunk_records = 1 << 16;
+		std::size_t max_chunks = 32;			//the oldest chunk is evicted as a whole; at least 1
+		std::size_t max_bytes = 256 << 20;		//a chunk is sealed at half of it, so the previous one is kept while the next fills
+	};
+
+	//Records of [from, to) with any of levels and all of tags; empty levels means any level.
+	//limit keeps the most recent records.
+	template <typename value_t>
+	struct recent_log_query
+	{
+		std::optional<std::chrono::system_clock::time_point> from;
+		std::optional<std::chrono::system_clock::time_point> to;
+		std::vector<level> levels;
+		std::vector<std::pair<std::string, value_t>> tags;
+		std::size_t limit = std::numeric_limits<std::size_t>::max();
+	};
+
+	namespace details
+	{
+		//selected[i] = levels[i] is one of wanted ? 0xFF : 0
+		inline void select_levels(const std::uint8_t* levels, std::size_t count, const std::vector<std::uint8_t>& wanted, std::uint8_t* selected)
+		{
+			std::size_t index = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+			for (; index + 16 <= count; index += 16)
+			{
+				const auto values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(levels + index));
+				auto mask = _mm_setzero_si128();
+				for (const auto lvl : wanted)
+					mask = _mm_or_si128(mask, _mm_cmpeq_epi8(values, _mm_set1_epi8(static_cast<char>(lvl))));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(selected + index), mask);
+			}
+#endif
+			for (; index < count; ++index)
+			{
+				std::uint8_t mask = 0;
+				for (const auto lvl : wanted)
+					mask |= levels[index] == lvl ? 0xFF : 0;
+				selected[index] = mask;
+			}
+		}
+
+		//Branchless, so it is vectorized by compiler
+		inline void select_times(const std::int64_t* times, std::size_t count, std::int64_t from, std::int64_t to, std::uint8_t* selected)
+		{
+			for (std::size_t index = 0; index < count; ++index)
+				selected[index] &= static_cast<std::uint8_t>(-static_cast<int>((times[index] >= from) & (times[index] < to)));
+		}
+	} //namespace details
+
+	//Keeps recent records column-wise for queries of a live debug endpoint:
+	//times and levels are arrays, messages are offsets into an arena, keys and values of other tags are dictionary-encoded per chunk.
+	//Memory is bounded by count of chunks and bytes; chunks are evicted from the oldest.
+	//Types of messages are not kept: a message is returned as std::string.
+	template <typename traits_t>
+	class recent_log_store :
+		public utils::noncopyable
+	{
+	public:
+		using key_t = typename traits_t::key_t;
+		using value_t = typename traits_t::value_t;
+		using tag_t = typename traits_t::tag_t;
+		using tags_t = typename traits_t::tags_t;
+		using tags_handle_t = typename traits_t::tags_handle_t;
+		using query_t = recent_log_query<value_t>;
+
+	private:
+		struct chunk
+		{
+			std::vector<std::int64_t> times;
+			std::vector<std::uint8_t> levels;
+			std::string arena;
+			std::vector<std::uint32_t> messages;	//offsets into arena; count of records + 1
+			std::vector<std::uint32_t> tags_begin;	//offsets into tags; count of records + 1
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> tags;	//ids of key and value
+			std::unordered_map<std::string, std::uint32_t> keys_index;
+			std::vector<key_t> keys;
+			std::unordered_map<std::string, std::uint32_t> values_index;
+			std::vector<value_t> values;
+			std::int64_t min_time = std::numeric_limits<std::int64_t>::max();
+			std::int64_t max_time = std::numeric_limits<std::int64_t>::min();
+			std::size_t bytes = 0;
+
+			std::size_t size() const
+			{
+				return times.size();
+			}
+		};
+
+	public:
+		//Throws std::invalid_argument if max_chunks is 0
+		explicit recent_log_store(const recent_log_options& options = {}) :
+			options(options)
+		{
+			if (options.max_chunks == 0)
+				throw std::invalid_argument("recent_log_store: max_chunks is 0");
+		}
+
+	public:
+		void push(const tags_handle_t& tags_handle)
+		{
+			const auto& tags = traits_t::extract_tags(tags_handle);
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			if (chunks.empty() || chunks.back().size() >= options.chunk_records || chunks.back().bytes >= options.max_bytes / 2)
+				add_chunk();
+			auto& c = chunks.back();
+			const auto bytes = c.bytes;
+
+			//arguments of LOGGERPP_LOG are kept in the rendered message only, as binary_log_writer does
+			const auto end = tags.size() - get_site_args_count(tags);
+			std::int64_t time = 0;
+			std::uint8_t lvl = static_cast<std::uint8_t>(level::unknown);
+			for (std::size_t index = 0; index < end; ++index)
+			{
+				const auto& tag = tags[index];
+				if (index == constants::index_time && std::holds_alternative<std::chrono::system_clock::time_point>(tag.value))
+					time = details::binary_log::to_nanoseconds(std::get<std::chrono::system_clock::time_point>(tag.value));
+				else if (index == constants::index_level && std::holds_alternative<level>(tag.value))
+					lvl = static_cast<std::uint8_t>(std::get<level>(tag.value));
+				else if (index == constants::index_message)
+				{
+					const auto message = get_site_id(tags) != nullptr ? get_message(tags) : to_string(tag.value);
+					c.arena.append(message);
+					c.bytes += message.size();
+				}
+				else
+					c.tags.emplace_back(get_id(c.keys_index, c.keys, tag.key, c.bytes), get_id(c.values_index, c.values, tag.value, c.bytes));
+			}
+			//fields of schema are kept as tags, so they are queried as tags too
+			details::for_each_schema_tag<value_t>(tags, [this, &c] (const char* key, const value_t& value) {
+				c.tags.emplace_back(get_id(c.keys_index, c.keys, key_t{std::string(key)}, c.bytes), get_id(c.values_index, c.values, value, c.bytes));
+			});
+			c.times.push_back(time);
+			c.levels.push_back(lvl);
+			c.messages.push_back(static_cast<std::uint32_t>(c.arena.size()));
+			c.tags_begin.push_back(static_cast<std::uint32_t>(c.tags.size()));
+			c.min_time = std::min(c.min_time, time);
+			c.max_time = std::max(c.max_time, time);
+			c.bytes += sizeof(std::int64_t) + 1 + 2 * sizeof(std::uint32_t) + (c.tags.size() - c.tags_begin[c.size() - 1]) * 2 * sizeof(std::uint32_t);
+			total_bytes += c.bytes - bytes;
+
+			while (chunks.size() > 1 && total_bytes > options.max_bytes)
+				evict();
+		}
+
+		std::vector<tags_t> query(const query_t& q) const
+		{
+			const auto from = q.from ? details::binary_log::to_nanoseconds(*q.from) : std::numeric_limits<std::int64_t>::min();
+			const auto to = q.to ? details::binary_log::to_nanoseconds(*q.to) : std::numeric_limits<std::int64_t>::max();
+			std::vector<std::uint8_t> wanted;
+			for (const auto lvl : q.levels)
+				wanted.push_back(static_cast<std::uint8_t>(lvl));
+			if (q.levels.empty())
+				for (std::uint8_t lvl = 0; lvl <= static_cast<std::uint8_t>(level::critical); ++lvl)
+					wanted.push_back(lvl);
+
+			std::vector<tags_t> result;
+			std::vector<std::uint8_t> selected;
+			std::string scratch;
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			for (auto c = chunks.rbegin(); c != chunks.rend() && result.size() < q.limit; ++c)
+			{
+				if (c->size() == 0 || c->max_time < from || c->min_time >= to)
+					continue;
+
+				//a value which is absent in the chunk dictionaries can't match
+				std::vector<std::pair<std::uint32_t, std::uint32_t>> required;
+				bool possible = true;
+				for (const auto& [key, value] : q.tags)
+				{
+					const auto key_id = find_id(c->keys_index, key_t{key}, scratch);
+					const auto value_id = find_id(c->values_index, value, scratch);
+					if (!key_id || !value_id)
+					{
+						possible = false;
+						break;
+					}
+					required.emplace_back(*key_id, *value_id);
+				}
+				if (!possible)
+					continue;
+
+				selected.resize(c->size());
+				details::select_levels(c->levels.data(), c->size(), wanted, selected.data());
+				details::select_times(c->times.data(), c->size(), from, to, selected.data());
+
+				for (auto row = c->size(); row-- > 0 && result.size() < q.limit; )
+					if (selected[row] != 0 && has_tags(*c, row, required))
+						result.push_back(make_tags(*c, row));
+			}
+			std::reverse(result.begin(), result.end());
+			return result;
+		}
+
+		std::size_t get_records_count() const
+		{
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			std::size_t count = 0;
+			for (const auto& c : chunks)
+				count += c.size();
+			return count;
+		}
+
+	private:
+		void add_chunk()
+		{
+			if (chunks.size() >= options.max_chunks)
+				evict();
+			auto& c = chunks.emplace_back();
+			c.times.reserve(options.chunk_records);
+			c.levels.reserve(options.chunk_records);
+			c.messages.reserve(options.chunk_records + 1);
+			c.tags_begin.reserve(options.chunk_records + 1);
+			c.messages.push_back(0);
+			c.tags_begin.push_back(0);
+		}
+
+		void evict()
+		{
+			total_bytes -= chunks.front().bytes;
+			chunks.pop_front();
+		}
+
+		template <typename item_t>
+		std::uint32_t get_id(std::unordered_map<std::string, std::uint32_t>& index, std::vector<item_t>& items, const item_t& item, std::size_t& bytes)
+		{
+			encode(item, scratch);
+			const auto iter = index.find(scratch);
+			if (iter != index.end())
+				return iter->second;
+			const auto id = static_cast<std::uint32_t>(items.size());
+			index.emplace(scratch, id);
+			items.push_back(item);
+			bytes += 2 * scratch.size() + sizeof(item_t);
+			return id;
+		}
+
+		template <typename item_t>
+		static std::optional<std::uint32_t> find_id(const std::unordered_map<std::string, std::uint32_t>& index, const item_t& item, std::string& scratch)
+		{
+			encode(item, scratch);
+			const auto iter = index.find(scratch);
+			if (iter == index.end())
+				return std::nullopt;
+			return iter->second;
+		}
+
+		template <typename item_t>
+		static void encode(const item_t& item, std::string& out)
+		{
+			out.clear();
+			details::binary_log::buffer_writer writer(out);
+			writer.put_value(item);
+		}
+
+		static bool has_tags(const chunk& c, std::size_t row, const std::vector<std::pair<std::uint32_t, std::uint32_t>>& required)
+		{
+			const auto begin = c.tags.begin() + c.tags_begin[row];
+			const auto end = c.tags.begin() + c.tags_begin[row + 1];
+			return std::all_of(required.begin(), required.end(), [begin, end] (const auto& tag) {
+				return std::find(begin, end, tag) != end;
+			});
+		}
+
+		static tags_t make_tags(const chunk& c, std::size_t row)
+		{
+			tags_t tags;
+			tags.push_back(tag_t{constants::key_time, details::binary_log::from_nanoseconds(c.times[row])});
+			tags.push_back(tag_t{constants::key_level, static_cast<level>(c.levels[row])});
+			tags.push_back(tag_t{constants::key_message, c.arena.substr(c.messages[row], c.messages[row + 1] - c.messages[row])});
+			for (auto index = c.tags_begin[row]; index < c.tags_begin[row + 1]; ++index)
+			{
+				const auto& key = c.keys[c.tags[index].first];
+				const auto& value = c.values[c.tags[index].second];
+				if (!details::set_schema_tag(tags, to_string(key), value))
+					tags.push_back(tag_t{key, value});
+			}
+			return tags;
+		}
+
+	private:
+		const recent_log_options options;
+		mutable std::shared_mutex mutex;
+		std::deque<chunk> chunks;
+		std::size_t total_bytes = 0;
+		std::string scratch;
+	};
+
+	template <typename traits_t>
+	inline auto build_recent_log_consumer(const std::shared_ptr<recent_log_store<traits_t>>& store)
+	{
+		return [store] (const typename traits_t::tags_handle_t& tags_handle) {
+			store->push(tags_handle);
+		};
+	}
+} //namespace charivari_ltd::loggerpp
@@ -34,8 +34,14 @@
 #pragma once
 
 #include "logger.h"
+#include "file_log_consumer.h"
+#include "log_worker.h"
+#include "thread_pool.h"
 
-#include <utils/task_queue.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
 
 namespace charivari_ltd
 {
@@ -51,6 +57,27 @@ namespace loggerpp
 			return std::make_shared<const tags_t>(std::move(tags));
 		}
 
+		//Records of extended loggers refer to the context, so sinks reuse the rendered context tags.
+		//The render cache is made only if several text consumers of the dispatcher share rendered records.
+		static inline tags_handle_t make_tags_handle(tags_t&& tags, const details::context_ptr& context, bool render_shared)
+		{
+			if (context == nullptr && !render_shared)
+				return make_tags_handle(std::move(tags));
+			return details::make_cached_tags(std::move(tags), context, render_shared);
+		}
+
+		static inline const details::render_cache* get_render_cache(const tags_handle_t& tags)
+		{
+			const auto cached = details::find_cached_tags(tags);
+			return cached == nullptr || !cached->cache ? nullptr : &*cached->cache;
+		}
+
+		static inline const details::context_cache* get_context(const tags_handle_t& tags)
+		{
+			const auto cached = details::find_cached_tags(tags);
+			return cached == nullptr ? nullptr : cached->context.get();
+		}
+
 		static inline const tags_t& extract_tags(const tags_handle_t& tags)
 		{
 			if (tags == nullptr)
@@ -59,6 +86,32 @@ namespace loggerpp
 		}
 	};
 
+	//Records are rendered in the format of file_log_consumer by the logging thread,
+	//so the dispatcher and file consumers only write the ready text
+	struct producer_text_log_traits :
+		shared_tags_log_traits
+	{
+		static constexpr serialization serialization_mode = serialization::on_producer;
+
+		static inline tags_handle_t make_tags_handle(tags_t&& tags)
+		{
+			return make_tags_handle(std::move(tags), nullptr, true);
+		}
+
+		static inline tags_handle_t make_tags_handle(tags_t&& tags, const details::context_ptr& context, bool)
+		{
+			return details::make_cached_tags(std::move(tags), context, true);
+		}
+
+		static inline void serialize(const tags_handle_t& tags_handle)
+		{
+			if (const auto cache = get_render_cache(tags_handle))
+				details::get_rendered<details::text_record_format>(*cache, [&tags_handle] (std::ostream& out) {
+					details::write_text_record<producer_text_log_traits>(out, *tags_handle, get_context(tags_handle), get_render_cache(tags_handle));
+				});
+		}
+	};
+
 	inline std::chrono::system_clock::time_point get_time(const shared_tags_log_traits::tags_handle_t& tags)
 	{
 		return get_time(shared_tags_log_traits::extract_tags(tags));
@@ -96,21 +149,107 @@ namespace loggerpp
 		base_default_consumer<shared_tags_log_traits>(tags_handle);
 	}
 
+	inline const auto shared_tags_default_text_consumer = details::make_text_consumer(&shared_tags_default_consumer);
+
+	namespace details
+	{
+		//Records which reach the queue of consumer after dispatcher::shutdown stopped it are skipped and counted
+		struct consumer_queue_state
+		{
+			std::atomic_bool stopped {false};
+			std::atomic<std::size_t> skipped {0};
+		};
+
+		//Waits for the tasks pushed before; the queue executes tasks in order of push
+		template <typename queue_t>
+		inline bool wait_queue(queue_t& queue, const std::chrono::steady_clock::time_point& deadline)
+		{
+			auto promise = std::make_shared<std::promise<void>>();
+			auto future = promise->get_future();
+			queue.push([promise] {
+				promise->set_value();
+			});
+			return future.wait_until(deadline) == std::future_status::ready;
+		}
+	}//namespace details
+
+	//dispatcher::flush waits for the records queued to the thread, dispatcher::shutdown stops it
 	template <typename consumer_t>
-	inline auto run_own_thread(consumer_t&& consumer)
+	inline auto run_own_thread(consumer_t&& consumer, const thread_options& options = {})
 	{
-		auto queue = std::make_shared<utils::task_queue>();
-		return [queue, consumer{std::move(consumer)}] (const auto& tags_handle) {
-			queue->push([&consumer, tags_handle] {
-				consumer(tags_handle);
+		worker_options queue_options;
+		queue_options.thread = options;
+		auto queue = std::make_shared<worker>([] (std::exception_ptr ptr) {
+			std::rethrow_exception(ptr);
+		}, queue_options);
+		auto state = std::make_shared<details::consumer_queue_state>();
+		auto wrapper = details::wrap_consumer<consumer_t>([queue, state, consumer{std::move(consumer)}] (const auto& tags_handle) {
+			queue->push([&consumer, state, tags_handle] {
+				if (state->stopped.load(std::memory_order_acquire))
+					state->skipped.fetch_add(1, std::memory_order_relaxed);
+				else
+					consumer(tags_handle);
 			});
+		});
+		return details::make_flushable_consumer(std::move(wrapper), [queue] (const std::chrono::steady_clock::time_point& deadline) {
+			return details::wait_queue(*queue, deadline);
+		}, [queue, state] {
+			state->stopped.store(true, std::memory_order_release);
+			queue->join();
+			return state->skipped.load(std::memory_order_relaxed);
+		});
+	}
+
+	namespace details
+	{
+		template <typename consumer_t>
+		struct pooled_consumer
+		{
+			pooled_consumer(const std::shared_ptr<thread_pool>& pool, consumer_t consumer) :
+				consumer(std::move(consumer)),
+				tasks(pool)
+			{}
+
+			consumer_t consumer;
+			consumer_queue_state state;
+			strand tasks;	//destructed first: waits while consumer is in use
 		};
+	}//namespace details
+
+	//dispatcher::flush waits for the records queued to the strand, dispatcher::shutdown stops it
+	template <typename consumer_t>
+	inline auto run_in_pool(const std::shared_ptr<thread_pool>& pool, consumer_t&& consumer)
+	{
+		auto pooled = std::make_shared<details::pooled_consumer<std::decay_t<consumer_t>>>(pool, std::forward<consumer_t>(consumer));
+		auto wrapper = details::wrap_consumer<consumer_t>([pooled] (const auto& tags_handle) {
+			pooled->tasks.push([pooled = pooled.get(), tags_handle] {
+				if (pooled->state.stopped.load(std::memory_order_acquire))
+					pooled->state.skipped.fetch_add(1, std::memory_order_relaxed);
+				else
+					pooled->consumer(tags_handle);
+			});
+		});
+		return details::make_flushable_consumer(std::move(wrapper), [pooled] (const std::chrono::steady_clock::time_point& deadline) {
+			return details::wait_queue(pooled->tasks, deadline);
+		}, [pooled] {
+			pooled->state.stopped.store(true, std::memory_order_release);
+			pooled->tasks.join();
+			return pooled->state.skipped.load(std::memory_order_relaxed);
+		});
+	}
+
+	template <typename consumer_t>
+	inline auto run_in_pool(consumer_t&& consumer)
+	{
+		return run_in_pool(shared_thread_pool(), std::forward<consumer_t>(consumer));
 	}
 
 	namespace details
 	{
 		struct forward_to_thread {};
 
+		struct forward_to_pool {};
+
 		template <typename logger_t>
 		struct forward_logger_to_thread
 		{
@@ -134,8 +273,35 @@ namespace loggerpp
 	{
 		return ref.ref >> run_own_thread(std::move(consumer));
 	}
+
+	namespace details
+	{
+		template <typename logger_t>
+		struct forward_logger_to_pool
+		{
+			const logger_t& ref;
+		};
+	}//namespace details
+
+	inline details::forward_to_pool run_in_pool()
+	{
+		return {};
+	}
+
+	template <typename traits_t>
+	inline auto operator >> (const logger_base<traits_t>& ref, const details::forward_to_pool&)
+	{
+		return details::forward_logger_to_pool<logger_base<traits_t>>{ref};
+	}
+
+	template <typename logger_t, typename consumer_t>
+	inline auto operator >> (const details::forward_logger_to_pool<logger_t>& ref, consumer_t&& consumer)
+	{
+		return ref.ref >> run_in_pool(std::move(consumer));
+	}
 } //namespace loggerpp
 
 	using shared_tags_logger = loggerpp::logger_base<loggerpp::shared_tags_log_traits>;
+	using producer_text_logger = loggerpp::logger_base<loggerpp::producer_text_log_traits>;
 } //namespace charivari_ltd
 
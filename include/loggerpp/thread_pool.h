@@ -0,0 +1,308 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#pragma once
+
+#include "log_thread.h"
+
+#include <utils/noncopyable.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace charivari_ltd::loggerpp
+{
+	//Small work-stealing pool: each thread owns a queue and steals from the others when it runs out of work.
+	class thread_pool :
+		public utils::noncopyable
+	{
+	public:
+		using task_t = std::function<void ()>;
+		using exception_handler_t = std::function<void (std::exception_ptr)>;
+
+	public:
+		static std::size_t default_threads_count()
+		{
+			return std::clamp<std::size_t>(std::thread::hardware_concurrency(), 2, 4);
+		}
+
+	public:
+		thread_pool() :
+			thread_pool(default_threads_count())
+		{}
+
+		explicit thread_pool(std::size_t threads_count) :
+			thread_pool(threads_count, [] (std::exception_ptr ptr) {
+				std::rethrow_exception(ptr);
+			})
+		{}
+
+		thread_pool(std::size_t threads_count, exception_handler_t&& handler, const thread_options& options = {}) :
+			exception_handler(std::move(handler)),
+			options(options)
+		{
+			threads_count = std::max<std::size_t>(threads_count, 1);
+			for (std::size_t index = 0; index < threads_count; ++index)
+				queues.push_back(std::make_unique<worker_queue>());
+			for (std::size_t index = 0; index < threads_count; ++index)
+				threads.emplace_back([this, index] {
+					run(index);
+				});
+		}
+
+		~thread_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(sleep_mutex);
+				stopped = true;
+			}
+			wakeup.notify_all();
+			for (auto& thread : threads)
+				thread.join();
+		}
+
+	public:
+		std::size_t get_threads_count() const
+		{
+			return threads.size();
+		}
+
+		void push(task_t&& task)
+		{
+			const auto index = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+			{
+				std::lock_guard<std::mutex> lock(queues[index]->mutex);
+				queues[index]->tasks.push_back(std::move(task));
+			}
+			//a worker counts itself in sleepers before it checks pending, so one of them sees the other
+			pending.fetch_add(1);
+			if (sleepers.load() == 0)
+				return;
+			{
+				//the worker may be between the check and the wait
+				std::lock_guard<std::mutex> lock(sleep_mutex);
+			}
+			wakeup.notify_one();
+		}
+
+		void handle(std::exception_ptr ptr)
+		{
+			exception_handler(ptr);
+		}
+
+	private:
+		struct worker_queue
+		{
+			std::mutex mutex;
+			std::deque<task_t> tasks;
+		};
+
+		void run(std::size_t index)
+		{
+			try {
+				apply_thread_options(options);
+			} catch (...) {
+				handle(std::current_exception());
+			}
+
+			for (;;)
+			{
+				if (!claim())
+				{
+					std::unique_lock<std::mutex> lock(sleep_mutex);
+					sleepers.fetch_add(1);
+					wakeup.wait(lock, [this] {
+						return pending.load() != 0 || stopped;
+					});
+					sleepers.fetch_sub(1);
+					if (pending.load() == 0)
+						return;
+					continue;
+				}
+
+				task_t task = pop(index);
+				try {
+					task();
+				} catch (...) {
+					handle(std::current_exception());
+				}
+			}
+		}
+
+		//Takes one of pending tasks; false if there are none
+		bool claim()
+		{
+			auto count = pending.load(std::memory_order_relaxed);
+			while (count != 0 && !pending.compare_exchange_weak(count, count - 1))
+				;
+			return count != 0;
+		}
+
+		//The caller already owns one pending task, so some queue is guaranteed to hold it
+		task_t pop(std::size_t index)
+		{
+			for (;;)
+			{
+				for (std::size_t shift = 0; shift < queues.size(); ++shift)
+				{
+					auto& queue = *queues[(index + shift) % queues.size()];
+					std::lock_guard<std::mutex> lock(queue.mutex);
+					if (queue.tasks.empty())
+						continue;
+					task_t task;
+					if (shift == 0)
+					{
+						task = std::move(queue.tasks.front());
+						queue.tasks.pop_front();
+					}
+					else
+					{
+						task = std::move(queue.tasks.back());
+						queue.tasks.pop_back();
+					}
+					return task;
+				}
+				std::this_thread::yield();
+			}
+		}
+
+	private:
+		exception_handler_t exception_handler;
+		const thread_options options;
+		std::vector<std::unique_ptr<worker_queue>> queues;
+		std::atomic<std::size_t> next_queue {0};
+
+		std::atomic<std::size_t> pending {0};		//pushed tasks which are not claimed by workers
+		std::atomic<std::size_t> sleepers {0};
+		std::mutex sleep_mutex;
+		std::condition_variable wakeup;
+		bool stopped = false;
+
+		std::vector<std::thread> threads;
+	};
+
+	//Executes tasks one by one in order of push on top of thread_pool
+	class strand :
+		public utils::noncopyable
+	{
+	public:
+		explicit strand(const std::shared_ptr<thread_pool>& pool) :
+			pool(pool)
+		{}
+
+		//Waits while all the pushed tasks are finishing
+		~strand()
+		{
+			join();
+		}
+
+	public:
+		void push(thread_pool::task_t&& task)
+		{
+			bool schedule = false;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.push_back(std::move(task));
+				schedule = !running;
+				running = true;
+			}
+			if (schedule)
+				schedule_run();
+		}
+
+		//Waits while all the pushed tasks are finishing
+		void join()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			idle.wait(lock, [this] {
+				return !running;
+			});
+		}
+
+	private:
+		static const std::size_t tasks_per_run = 64;
+
+		void schedule_run()
+		{
+			pool->push([this] {
+				run();
+			});
+		}
+
+		void run()
+		{
+			for (std::size_t index = 0; index < tasks_per_run; ++index)
+			{
+				thread_pool::task_t task;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (tasks.empty())
+					{
+						running = false;
+						idle.notify_all();
+						return;
+					}
+					task = std::move(tasks.front());
+					tasks.pop_front();
+				}
+				try {
+					task();
+				} catch (...) {
+					pool->handle(std::current_exception());
+				}
+			}
+			schedule_run();
+		}
+
+	private:
+		std::shared_ptr<thread_pool> pool;
+		std::mutex mutex;
+		std::condition_variable idle;
+		std::deque<thread_pool::task_t> tasks;
+		bool running = false;
+	};
+
+	inline std::shared_ptr<thread_pool> shared_thread_pool()
+	{
+		static auto pool = std::make_shared<thread_pool>();
+		return pool;
+	}
+} //namespace charivari_ltd::loggerpp
@@ -0,0 +1,283 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+//Separate test binary: replaces global operator new/delete to count allocations of the log path
+
+#include <loggerpp/shared_tags_logger.h>
+#include <loggerpp/flight_recorder.h>
+#include <loggerpp/log_schema.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	//Allocations of all threads are counted, so the work of the dispatcher thread is included to the budget
+	std::atomic<std::size_t> allocations_count {0};
+
+	void* allocate(std::size_t size)
+	{
+		allocations_count.fetch_add(1, std::memory_order_relaxed);
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	void* allocate(std::size_t size, std::align_val_t alignment)
+	{
+		allocations_count.fetch_add(1, std::memory_order_relaxed);
+		const auto align = static_cast<std::size_t>(alignment);
+		return std::aligned_alloc(align, (size + align - 1) / align * align);
+	}
+
+	void* allocate_or_throw(std::size_t size)
+	{
+		if (auto ptr = allocate(size))
+			return ptr;
+		throw std::bad_alloc();
+	}
+
+	void* allocate_or_throw(std::size_t size, std::align_val_t alignment)
+	{
+		if (auto ptr = allocate(size, alignment))
+			return ptr;
+		throw std::bad_alloc();
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	return allocate_or_throw(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return allocate_or_throw(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return allocate_or_throw(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return allocate_or_throw(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+
+using namespace charivari_ltd;
+
+namespace
+{
+	struct request_context
+	{
+		std::string request_id;
+		std::int64_t entity = 0;
+
+		static constexpr auto fields()
+		{
+			return std::make_tuple(loggerpp::field("request_id", &request_context::request_id), loggerpp::field("entity", &request_context::entity));
+		}
+	};
+
+	using schema_log_traits = loggerpp::schema_log_traits<request_context>;
+}
+
+//Maximal average count of allocations of the producer and the dispatcher threads per logger.info("x {}", i) call.
+//The budgets are the measured counts (GCC 12, libstdc++) plus a small margin.
+//Lower the budget when an optimization lands; never raise it without a reason.
+template <typename traits_t>
+struct allocation_budget;
+
+template <>
+struct allocation_budget<loggerpp::default_log_traits>
+{
+	static constexpr double per_call = 19.5;
+};
+
+template <>
+struct allocation_budget<loggerpp::shared_tags_log_traits>
+{
+	static constexpr double per_call = 14.5;
+};
+
+template <>
+struct allocation_budget<loggerpp::sync_log_traits>
+{
+	static constexpr double per_call = 19.5;
+};
+
+template <>
+struct allocation_budget<loggerpp::producer_text_log_traits>
+{
+	static constexpr double per_call = 20.5;
+};
+
+template <>
+struct allocation_budget<schema_log_traits>
+{
+	static constexpr double per_call = 19.5;
+};
+
+template <typename traits_t>
+class allocations_test_suite :
+	public testing::Test
+{
+public:
+	static const std::size_t warmup_count = 1'000;
+	static const std::size_t calls_count = 100'000;
+};
+
+using traits_types = testing::Types<loggerpp::default_log_traits, loggerpp::shared_tags_log_traits, loggerpp::sync_log_traits, loggerpp::producer_text_log_traits, schema_log_traits>;
+TYPED_TEST_SUITE(allocations_test_suite, traits_types);
+
+TYPED_TEST(allocations_test_suite, info_with_null_consumer)
+{
+	using logger_t = loggerpp::logger_base<TypeParam>;
+	logger_t root;
+	auto subscription = root >> [] (const auto&) {};
+
+	for (std::size_t index = 0; index < TestFixture::warmup_count; ++index)
+		root.info("x {}", index);
+	ASSERT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+
+	const auto before = allocations_count.load();
+	for (std::size_t index = 0; index < TestFixture::calls_count; ++index)
+		root.info("x {}", index);
+	ASSERT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+	const auto per_call = static_cast<double>(allocations_count.load() - before) / TestFixture::calls_count;
+
+	this->RecordProperty("allocations_per_call", std::to_string(per_call));
+	EXPECT_LE(per_call, allocation_budget<TypeParam>::per_call);
+}
+
+TYPED_TEST(allocations_test_suite, flight_recorder_stores_without_allocations)
+{
+	loggerpp::flight_recorder<TypeParam> recorder([] (const auto&) {}, {64, 1 << 16});
+	const auto tags = TypeParam::make_tags_handle({
+		{std::string("time"), std::chrono::system_clock::now()},
+		{std::string("level"), loggerpp::level::debug},
+		{std::string("message"), std::string("a message which does not fit to small string buffer")},
+		{std::string("id"), std::int64_t{42}},
+	});
+
+	for (std::size_t index = 0; index < TestFixture::warmup_count; ++index)
+		recorder.push(tags);
+
+	const auto before = allocations_count.load();
+	for (std::size_t index = 0; index < TestFixture::calls_count; ++index)
+		recorder.push(tags);
+	EXPECT_EQ(allocations_count.load() - before, 0);
+	EXPECT_EQ(recorder.get_records_count(), 64);
+}
@@ -0,0 +1,283 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/binary_log_consumer.h>
+#include <loggerpp/binary_log_reader.h>
+#include <loggerpp/shared_tags_logger.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace charivari_ltd;
+
+class binary_log_test_suite :
+	public testing::Test
+{
+public:
+	void SetUp()
+	{
+		std::remove(log_test_file_name.c_str());
+	}
+
+	void TearDown()
+	{
+		std::remove(log_test_file_name.c_str());
+	}
+
+	static logger::tags_handle_t make_record(int second, loggerpp::level lvl, const std::string& message)
+	{
+		return {
+			{std::string("time"), std::chrono::system_clock::time_point(std::chrono::seconds(second))},
+			{std::string("level"), lvl},
+			{std::string("message"), message},
+		};
+	}
+
+	void write_records(std::size_t block_records)
+	{
+		loggerpp::binary_log_writer<loggerpp::default_log_traits> writer(log_test_file_name, {block_records, 1 << 20});
+		for (int second = 1; second <= 6; ++second)
+		{
+			auto record = make_record(second, second % 2 == 0 ? loggerpp::level::error : loggerpp::level::info, std::to_string(second));
+			if (second == 5)
+				record.push_back({std::wstring(L"user"), std::wstring(L"root")});
+			writer.push(record);
+		}
+	}
+
+	std::vector<std::string> read_messages(const loggerpp::binary_log_query& query)
+	{
+		std::vector<std::string> result;
+		loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(log_test_file_name);
+		const auto count = reader.read(query, [&result] (const logger::tags_handle_t& tags) {
+			result.push_back(get_message(tags));
+		});
+		EXPECT_EQ(count, result.size());
+		return result;
+	}
+
+public:
+	const std::string log_test_file_name = "log.lpb";
+};
+
+TEST_F(binary_log_test_suite, read_all)
+{
+	write_records(2);
+	loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(log_test_file_name);
+	ASSERT_EQ(reader.get_blocks().size(), 3);
+	EXPECT_EQ(reader.get_blocks()[1].min_time, std::chrono::nanoseconds(std::chrono::seconds(3)).count());
+	EXPECT_EQ(reader.get_blocks()[1].max_time, std::chrono::nanoseconds(std::chrono::seconds(4)).count());
+
+	std::vector<logger::tags_t> check;
+	reader.read({}, [&check] (const logger::tags_handle_t& tags) {
+		check.push_back(tags);
+	});
+	ASSERT_EQ(check.size(), 6);
+	EXPECT_EQ(get_time(check[0]), std::chrono::system_clock::time_point(std::chrono::seconds(1)));
+	EXPECT_EQ(get_level(check[1]), loggerpp::level::error);
+	EXPECT_EQ(get_message(check[2]), "3");
+	EXPECT_EQ(loggerpp::get_tag<std::wstring>(check[4], L"user"), L"root");
+}
+
+TEST_F(binary_log_test_suite, write_rendered_site_message)
+{
+	const auto& site = loggerpp::sites().add(loggerpp::level::info, "{} + {}", __FILE__, __LINE__, __func__, 2);
+	{
+		loggerpp::binary_log_writer<loggerpp::default_log_traits> writer(log_test_file_name);
+		writer.push(logger::tags_handle_t{
+			{std::string("time"), std::chrono::system_clock::time_point(std::chrono::seconds(1))},
+			{std::string("level"), loggerpp::level::info},
+			{std::string("site"), site.id},
+			{std::string("entity"), std::string{"Test"}},
+			{std::string("0"), std::int64_t{1}},
+			{std::string("1"), std::int64_t{2}},
+		});
+	}
+
+	//the message is stored as text, so it's read without the sites of the writing process
+	std::vector<logger::tags_t> check;
+	loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(log_test_file_name);
+	reader.read({}, [&check] (const logger::tags_handle_t& tags) {
+		check.push_back(tags);
+	});
+	ASSERT_EQ(check.size(), 1);
+	EXPECT_EQ(loggerpp::get_tag<std::string>(check[0], "message"), "1 + 2");
+	EXPECT_EQ(loggerpp::get_tag<std::string>(check[0], "entity"), "Test");
+	EXPECT_FALSE(loggerpp::get_vtag(check[0], std::string("0")));
+	EXPECT_EQ(check[0].size(), 4);
+}
+
+TEST_F(binary_log_test_suite, read_by_query)
+{
+	write_records(2);
+
+	loggerpp::binary_log_query window;
+	window.from = std::chrono::system_clock::time_point(std::chrono::seconds(2));
+	window.to = std::chrono::system_clock::time_point(std::chrono::seconds(4));
+	EXPECT_EQ(read_messages(window), (std::vector<std::string>{"2", "3"}));
+
+	loggerpp::binary_log_query levels;
+	levels.levels = {loggerpp::level::error, loggerpp::level::critical};
+	EXPECT_EQ(read_messages(levels), (std::vector<std::string>{"2", "4", "6"}));
+
+	loggerpp::binary_log_query keys;
+	keys.keys = {"user"};
+	EXPECT_EQ(read_messages(keys), (std::vector<std::string>{"5"}));
+	keys.levels = {loggerpp::level::error};
+	EXPECT_TRUE(read_messages(keys).empty());
+
+	//blocks without the key are skipped by the index
+	loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(log_test_file_name);
+	const auto user = loggerpp::details::binary_log::get_key_bit("user");
+	ASSERT_EQ(reader.get_blocks().size(), 3);
+	EXPECT_EQ(reader.get_blocks()[0].key_bits & user, 0);
+	EXPECT_EQ(reader.get_blocks()[1].key_bits & user, 0);
+	EXPECT_EQ(reader.get_blocks()[2].key_bits & user, user);
+}
+
+TEST_F(binary_log_test_suite, append_to_file)
+{
+	write_records(4);
+	write_records(4);
+	loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(log_test_file_name);
+	EXPECT_EQ(reader.get_blocks().size(), 4);
+	EXPECT_EQ(read_messages({}).size(), 12);
+}
+
+TEST_F(binary_log_test_suite, recover_torn_file)
+{
+	write_records(2);
+	//the tail, the index and the end of the last block are lost
+	std::filesystem::resize_file(log_test_file_name, std::filesystem::file_size(log_test_file_name) - 154);
+	EXPECT_EQ(read_messages({}), (std::vector<std::string>{"1", "2", "3", "4"}));
+
+	write_records(2);
+	EXPECT_EQ(read_messages({}).size(), 10);
+}
+
+TEST_F(binary_log_test_suite, bad_file)
+{
+	{
+		std::ofstream file(log_test_file_name);
+		file << "text log";
+	}
+	EXPECT_THROW(loggerpp::binary_log_reader<loggerpp::default_log_traits>{log_test_file_name}, std::runtime_error);
+}
+
+TEST_F(binary_log_test_suite, bad_block_counts)
+{
+	//the count of records and the count of keys of the first block
+	for (const std::streamoff offset : {20, 52})
+	{
+		write_records(6);
+		{
+			std::fstream file(log_test_file_name, std::ios::in | std::ios::out | std::ios::binary);
+			const std::uint32_t count = 0xffffffff;
+			file.seekp(offset);
+			file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		}
+		EXPECT_THROW(read_messages({}), std::runtime_error);
+		std::remove(log_test_file_name.c_str());
+	}
+}
+
+TEST_F(binary_log_test_suite, log_to_binary_consumer)
+{
+	{
+		logger root;
+		auto subscription = root >> loggerpp::build_binary_log_consumer(log_test_file_name);
+		root.info("AAA {}", 1);
+		(root | logger::tag_t{"id", 7}).warning("BBB");
+	}
+
+	std::vector<logger::tags_t> check;
+	loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(log_test_file_name);
+	reader.read({}, [&check] (const logger::tags_handle_t& tags) {
+		check.push_back(tags);
+	});
+	ASSERT_EQ(check.size(), 2);
+	EXPECT_EQ(get_message(check[0]), "AAA 1");
+	EXPECT_EQ(get_message(check[1]), "BBB");
+	EXPECT_EQ(loggerpp::get_tag<std::int64_t>(check[1], "id"), 7);
+}
+
+TEST_F(binary_log_test_suite, flush_binary_consumer)
+{
+	logger root;
+	auto subscription = root >> loggerpp::build_binary_log_consumer(log_test_file_name);
+	root.info("AAA");
+	root.info("BBB");
+	EXPECT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+
+	//the index is written on destruction, so the block is found by scan of the file
+	std::vector<std::string> check;
+	loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(log_test_file_name);
+	reader.read({}, [&check] (const logger::tags_handle_t& tags) {
+		check.push_back(get_message(tags));
+	});
+	EXPECT_EQ(check, (std::vector<std::string>{"AAA", "BBB"}));
+}
+
+TEST_F(binary_log_test_suite, write_context_of_logger)
+{
+	{
+		shared_tags_logger root;
+		auto x = extend_logger(root, {{"request", std::int64_t{7}}, {std::wstring(L"user"), std::wstring(L"root")}});
+		auto subscription = root >> [writer = std::make_shared<loggerpp::binary_log_writer<loggerpp::shared_tags_log_traits>>(log_test_file_name)] (const auto& tags_handle) {
+			writer->push(tags_handle);
+		};
+		x.info("1");
+		root.log(loggerpp::level::info, shared_tags_logger::tags_t{{"user", std::string("guest")}}, "2");
+		x.info("3");
+	}
+
+	std::vector<logger::tags_t> check;
+	loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(log_test_file_name);
+	reader.read({}, [&check] (const logger::tags_handle_t& tags) {
+		check.push_back(tags);
+	});
+	ASSERT_EQ(check.size(), 3);
+	for (const auto index : {0, 2})
+	{
+		ASSERT_EQ(check[index].size(), 5);
+		EXPECT_EQ(loggerpp::get_tag<std::int64_t>(check[index], "request"), 7);
+		EXPECT_EQ(loggerpp::get_tag<std::wstring>(check[index], L"user"), L"root");
+	}
+	EXPECT_EQ(loggerpp::get_tag<std::string>(check[1], "user"), "guest");
+}
@@ -0,0 +1,155 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/crash_handler.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <future>
+#include <sstream>
+
+#include <fcntl.h>
+
+using namespace charivari_ltd;
+
+class crash_handler_test_suite :
+	public testing::Test
+{
+public:
+	void SetUp()
+	{
+		::unlink(crash_file_name.data());
+	}
+
+	std::string read_data()
+	{
+		std::ifstream file(crash_file_name);
+		std::stringstream check;
+		check << file.rdbuf();
+		return check.str();
+	}
+
+public:
+	const std::string crash_file_name = "crash.log";
+};
+
+TEST_F(crash_handler_test_suite, signal_safe_writer)
+{
+	{
+		const auto fd = ::open(crash_file_name.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		{
+			loggerpp::details::signal_safe_writer out(fd);
+			out.write_int(-42);
+			out.write('\t');
+			out.write_uint(18446744073709551615ULL);
+			out.write('\t');
+			out.write_double(-2.5);
+			out.write('\t');
+			loggerpp::details::write_signal_safe_variant(out, logger::traits_t::value_t{std::wstring{L"text"}});
+		}
+		::close(fd);
+	}
+	EXPECT_EQ(read_data(), "-42\t18446744073709551615\t-2.500000\ttext");
+}
+
+TEST_F(crash_handler_test_suite, write_site_record)
+{
+	const auto& site = loggerpp::sites().add(loggerpp::level::info, "{} + {}", __FILE__, __LINE__, __func__, 2);
+	{
+		const auto fd = ::open(crash_file_name.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		{
+			loggerpp::details::signal_safe_writer out(fd);
+			loggerpp::details::write_signal_safe_tags<loggerpp::default_log_traits>(out, logger::tags_t{
+				{std::string("time"), std::uint64_t{1}},
+				{std::string("level"), loggerpp::level::info},
+				{std::string("site"), site.id},
+				{std::string("entity"), std::string{"test"}},
+				{std::string("0"), std::int64_t{1}},
+				{std::string("1"), std::string{"x"}},
+			});
+		}
+		::close(fd);
+	}
+	EXPECT_EQ(read_data(), "1\tinfo\t1 + x\tentity=test\n");
+}
+
+namespace
+{
+	int previous_handler_fd = -1;
+
+	void crash_with_pending_records(const std::string& path)
+	{
+		const auto fd = ::open(path.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		std::promise<void> never;
+		auto blocked = never.get_future().share();
+
+		logger root;
+		auto subscription = root >> [blocked] (const auto&) {
+			blocked.wait();
+		};
+		auto flush = loggerpp::enable_emergency_flush(root, fd);
+		auto x = root | logger::tag_t{"entity", std::string{"test"}};
+		for (std::size_t index = 0; index < 3; ++index)
+			x.info("message {}", index);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		std::abort();
+	}
+}
+
+TEST_F(crash_handler_test_suite, flush_pending_records_on_abort)
+{
+	EXPECT_EXIT(crash_with_pending_records(crash_file_name), testing::KilledBySignal(SIGABRT), "");
+
+	const auto data = read_data();
+	EXPECT_NE(data.find("\tinfo\tmessage 1\tentity=test\n"), std::string::npos);
+	EXPECT_NE(data.find("\tinfo\tmessage 2\tentity=test\n"), std::string::npos);
+}
+
+TEST_F(crash_handler_test_suite, call_previous_handler)
+{
+	EXPECT_EXIT({
+		previous_handler_fd = ::open(crash_file_name.data(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+		std::signal(SIGABRT, [] (int) {
+			loggerpp::details::signal_safe_writer out(previous_handler_fd);
+			out.write("previous\n");
+			out.flush();
+			::_exit(3);
+		});
+		crash_with_pending_records(crash_file_name);
+	}, testing::ExitedWithCode(3), "");
+
+	const auto data = read_data();
+	EXPECT_NE(data.find("\tinfo\tmessage 2\tentity=test\n"), std::string::npos);
+	EXPECT_NE(data.find("previous\n"), std::string::npos);
+}
@@ -137,3 +137,19 @@ TEST_F(file_log_consumer_test_suite, check_bool)
 	check_data("true\nfalse\n");
 }
 
+TEST_F(file_log_consumer_test_suite, check_site)
+{
+	const auto& site = loggerpp::sites().add(loggerpp::level::info, "{} + {}", __FILE__, __LINE__, __func__, 2);
+	{
+		loggerpp::details::file_log_consumer<loggerpp::default_log_traits> consumer(log_test_file_name);
+		consumer.push(loggerpp::default_log_traits::tags_handle_t{
+			{std::string("time"), std::uint64_t{1534704464'123456789LL}},
+			{std::string("level"), loggerpp::level::info},
+			{std::string("site"), site.id},
+			{std::string("entity"), std::string{"Test"}},
+			{std::string("0"), std::int64_t{1}},
+			{std::string("1"), std::int64_t{2}},
+		});
+	}
+	check_data("1534704464123456789\tinfo\t1 + 2\tentity=Test\n");
+}
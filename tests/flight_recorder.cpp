@@ -0,0 +1,153 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/flight_recorder.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace charivari_ltd;
+
+class flight_recorder_test_suite :
+	public testing::Test
+{
+public:
+	static logger::tags_handle_t make_record(loggerpp::level lvl, const std::string& message)
+	{
+		return {
+			{std::string("time"), std::chrono::system_clock::now()},
+			{std::string("level"), lvl},
+			{std::string("message"), message},
+			{std::wstring(L"id"), std::int64_t{7}},
+		};
+	}
+
+	auto make_recorder(const loggerpp::flight_recorder_options& options)
+	{
+		return std::make_unique<loggerpp::flight_recorder<loggerpp::default_log_traits>>([this] (const logger::tags_handle_t& tags) {
+			check.push_back(get_message(tags));
+			EXPECT_EQ(loggerpp::get_tag<std::int64_t>(tags, L"id"), 7);
+		}, options);
+	}
+
+public:
+	std::vector<std::string> check;
+};
+
+TEST_F(flight_recorder_test_suite, dump_on_error)
+{
+	auto recorder = make_recorder({});
+	recorder->push(make_record(loggerpp::level::debug, "d1"));
+	recorder->push(make_record(loggerpp::level::info, "i1"));
+	recorder->push(make_record(loggerpp::level::trace, "t1"));
+	EXPECT_EQ(check, (std::vector<std::string>{"i1"}));
+	EXPECT_EQ(recorder->get_records_count(), 2);
+
+	recorder->push(make_record(loggerpp::level::error, "e1"));
+	EXPECT_EQ(check, (std::vector<std::string>{"i1", "d1", "t1", "e1"}));
+	EXPECT_EQ(recorder->get_records_count(), 0);
+}
+
+TEST_F(flight_recorder_test_suite, keep_last_records)
+{
+	auto recorder = make_recorder({3, 1 << 20});
+	for (int index = 0; index < 5; ++index)
+		recorder->push(make_record(loggerpp::level::debug, std::to_string(index)));
+	EXPECT_EQ(recorder->dump(), 3);
+	EXPECT_EQ(check, (std::vector<std::string>{"2", "3", "4"}));
+}
+
+TEST_F(flight_recorder_test_suite, keep_last_bytes)
+{
+	auto recorder = make_recorder({1000, 500});
+	for (int index = 0; index < 100; ++index)
+		recorder->push(make_record(loggerpp::level::debug, std::to_string(index)));
+	const auto count = recorder->get_records_count();
+	EXPECT_GT(count, 1);
+	EXPECT_LT(count, 100);
+	recorder->dump();
+	ASSERT_EQ(check.size(), count);
+	for (std::size_t index = 0; index < count; ++index)
+		EXPECT_EQ(check[index], std::to_string(100 - count + index));
+}
+
+TEST_F(flight_recorder_test_suite, limit_dumps_rate)
+{
+	loggerpp::flight_recorder_options options;
+	options.min_dump_interval = std::chrono::hours(1);
+	auto recorder = make_recorder(options);
+	recorder->push(make_record(loggerpp::level::debug, "d1"));
+	recorder->push(make_record(loggerpp::level::error, "e1"));
+	recorder->push(make_record(loggerpp::level::debug, "d2"));
+	recorder->push(make_record(loggerpp::level::critical, "c1"));
+	EXPECT_EQ(check, (std::vector<std::string>{"d1", "e1", "c1"}));
+	EXPECT_EQ(recorder->get_records_count(), 1);
+}
+
+TEST_F(flight_recorder_test_suite, dump_to_throwing_target)
+{
+	loggerpp::flight_recorder<loggerpp::default_log_traits> recorder([this] (const logger::tags_handle_t& tags) {
+		if (get_message(tags) == "throw")
+			throw std::runtime_error("target");
+		check.push_back(get_message(tags));
+	}, {});
+	recorder.push(make_record(loggerpp::level::debug, "d1"));
+	recorder.push(make_record(loggerpp::level::debug, "throw"));
+	recorder.push(make_record(loggerpp::level::debug, "d2"));
+	EXPECT_THROW(recorder.dump(), std::runtime_error);
+	EXPECT_EQ(recorder.get_records_count(), 1);
+
+	recorder.push(make_record(loggerpp::level::debug, "d3"));
+	EXPECT_EQ(recorder.dump(), 2);
+	EXPECT_EQ(check, (std::vector<std::string>{"d1", "d2", "d3"}));
+	EXPECT_EQ(recorder.get_records_count(), 0);
+}
+
+TEST_F(flight_recorder_test_suite, record_with_logger)
+{
+	std::vector<std::string> messages;
+	{
+		logger root;
+		auto subscription = root.get_dispatcher()->subscribe(loggerpp::build_flight_recorder([&messages] (const logger::tags_handle_t& tags) {
+			messages.push_back(get_message(tags));
+		}), loggerpp::ordering::strict);
+		root.debug("d1");
+		root.warning("w1");
+		root.error("e1");
+	}
+	EXPECT_EQ(messages, (std::vector<std::string>{"w1", "d1", "e1"}));
+}
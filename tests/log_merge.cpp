@@ -0,0 +1,118 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/log_merge.h>
+#include <loggerpp/binary_log_consumer.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace charivari_ltd;
+
+class log_merge_test_suite :
+	public testing::Test
+{
+public:
+	void TearDown()
+	{
+		for (const auto& path : {text1, text2, binary})
+			std::remove(path.c_str());
+	}
+
+	static void write_text(const std::string& path, const std::string& data)
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << data;
+	}
+
+	void write_binary()
+	{
+		std::remove(binary.c_str());
+		loggerpp::binary_log_writer<loggerpp::default_log_traits> writer(binary, {1, 1 << 20});
+		for (const int time : {15, 35})
+			writer.push({
+				{std::string("time"), std::chrono::system_clock::time_point(std::chrono::nanoseconds(time))},
+				{std::string("level"), loggerpp::level::info},
+				{std::string("message"), "b" + std::to_string(time)},
+			});
+	}
+
+public:
+	const std::string text1 = "merge1.log";
+	const std::string text2 = "merge2.log";
+	const std::string binary = "merge.lpb";
+};
+
+TEST_F(log_merge_test_suite, merge_text)
+{
+	write_text(text1, "10\tinfo\ta10\n30\terror\ta30\tid=1\n");
+	write_text(text2, "20\tinfo\tb20\ncontinued\n30\tinfo\tb30\n40\tinfo\tb40");
+
+	std::ostringstream out;
+	EXPECT_EQ(loggerpp::merge_logs({text1, text2}, out), 5);
+	EXPECT_EQ(out.str(), "10\tinfo\ta10\n20\tinfo\tb20\ncontinued\n30\terror\ta30\tid=1\n30\tinfo\tb30\n40\tinfo\tb40\n");
+}
+
+TEST_F(log_merge_test_suite, merge_text_and_binary)
+{
+	write_text(text1, "10\tinfo\ta10\n30\terror\ta30\n");
+	write_binary();
+
+	std::ostringstream out;
+	EXPECT_EQ(loggerpp::merge_logs({text1, binary}, out), 4);
+	EXPECT_EQ(out.str(), "10\tinfo\ta10\n15\tinfo\tb15\n30\terror\ta30\n35\tinfo\tb35\n");
+}
+
+TEST_F(log_merge_test_suite, merge_to_consumer)
+{
+	write_text(text1, "10\terror\ta10\tid=1\n");
+	write_text(text2, "");
+	write_binary();
+
+	std::vector<logger::tags_t> check;
+	loggerpp::merge_logs<loggerpp::default_log_traits>({binary, text1, text2}, [&check] (const logger::tags_handle_t& tags) {
+		check.push_back(tags);
+	});
+	ASSERT_EQ(check.size(), 3);
+	EXPECT_EQ(get_message(check[0]), "a10");
+	EXPECT_EQ(get_level(check[0]), loggerpp::level::error);
+	EXPECT_EQ(get_time(check[0]), std::chrono::system_clock::time_point(std::chrono::nanoseconds(10)));
+	EXPECT_EQ(loggerpp::get_tag<std::string>(check[0], "id"), "1");
+	EXPECT_EQ(get_message(check[1]), "b15");
+	EXPECT_EQ(get_message(check[2]), "b35");
+}
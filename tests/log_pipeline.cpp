@@ -0,0 +1,108 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/log_pipeline.h>
+#include <loggerpp/shared_tags_logger.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace charivari_ltd;
+
+class log_pipeline_test_suite :
+	public testing::Test
+{
+public:
+	struct collect
+	{
+		std::vector<std::string>* messages;
+
+		template <typename tags_handle_t>
+		void operator () (const tags_handle_t& tags_handle)
+		{
+			messages->push_back(get_message(tags_handle));
+		}
+	};
+
+	struct skip_secret
+	{
+		template <typename tags_handle_t>
+		bool operator () (const tags_handle_t& tags_handle) const
+		{
+			return get_message(tags_handle) != "secret";
+		}
+	};
+};
+
+TEST_F(log_pipeline_test_suite, filters_apply_to_next_stages)
+{
+	std::vector<std::string> all;
+	std::vector<std::string> errors;
+	{
+		logger root;
+		auto subscription = root.get_dispatcher()->subscribe(loggerpp::make_pipeline(
+			skip_secret{},
+			collect{&all},
+			loggerpp::level_filter<loggerpp::level::error>{},
+			collect{&errors}
+		), loggerpp::ordering::strict);
+		root.info("i1");
+		root.error("secret");
+		root.error("e1");
+		root.debug("d1");
+	}
+	EXPECT_EQ(all, (std::vector<std::string>{"i1", "e1", "d1"}));
+	EXPECT_EQ(errors, (std::vector<std::string>{"e1"}));
+}
+
+TEST_F(log_pipeline_test_suite, static_pipeline_type)
+{
+	static std::vector<std::string> messages;
+	struct sink
+	{
+		void operator () (const shared_tags_logger::tags_handle_t& tags_handle)
+		{
+			messages.push_back(get_message(tags_handle));
+		}
+	};
+
+	{
+		shared_tags_logger root;
+		auto subscription = root >> loggerpp::pipeline<loggerpp::level_filter<loggerpp::level::warning>, sink>{};
+		root.info("i1");
+		root.warning("w1");
+	}
+	EXPECT_EQ(messages, (std::vector<std::string>{"w1"}));
+}
@@ -0,0 +1,146 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/logger.h>
+#include <loggerpp/level_config_watcher.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace charivari_ltd;
+
+class log_registry_test_suite :
+	public testing::Test
+{
+};
+
+TEST_F(log_registry_test_suite, levels_are_inherited)
+{
+	loggerpp::level_registry registry;
+	const auto conn = registry.get_level("db.pool.conn");
+	const auto dbx = registry.get_level("dbx");
+	EXPECT_EQ(conn->load(), loggerpp::level::unknown);
+
+	registry.set_level("", loggerpp::level::warning);
+	registry.set_level("db", loggerpp::level::info);
+	EXPECT_EQ(conn->load(), loggerpp::level::info);
+	EXPECT_EQ(dbx->load(), loggerpp::level::warning);
+
+	registry.set_level("db.pool", loggerpp::level::debug);
+	EXPECT_EQ(conn->load(), loggerpp::level::debug);
+	EXPECT_EQ(registry.get_level("db.pool.conn.x")->load(), loggerpp::level::debug);
+
+	registry.reset_level("db.pool");
+	EXPECT_EQ(conn->load(), loggerpp::level::info);
+}
+
+TEST_F(log_registry_test_suite, levels_are_not_kept_by_registry)
+{
+	loggerpp::level_registry registry;
+	const auto conn = registry.get_level("db.pool.conn");
+	EXPECT_EQ(conn.use_count(), 1);
+	EXPECT_EQ(registry.get_level("db.pool.conn"), conn);
+
+	registry.get_level("db.tmp");
+	registry.set_level("db", loggerpp::level::error);
+	EXPECT_EQ(conn->load(), loggerpp::level::error);
+	EXPECT_EQ(registry.get_level("db.tmp")->load(), loggerpp::level::error);
+}
+
+TEST_F(log_registry_test_suite, named_logger_filters_records)
+{
+	loggerpp::level_registry registry;
+	registry.set_level("", loggerpp::level::warning);
+
+	std::vector<std::string> check;
+	logger root;
+	auto subscription = root.get_dispatcher()->subscribe([&check] (const auto& tags) {
+		check.push_back(get_message(tags) + "@" + loggerpp::get_tag<std::string>(tags, loggerpp::constants::key_logger).value());
+	}, loggerpp::ordering::strict);
+	auto db = loggerpp::get_logger(root, "db", registry);
+	auto conn = loggerpp::get_logger(root, "db.conn", registry) | logger::tag_t{"id", 1};
+	auto net = loggerpp::get_logger(root, "net", registry);
+
+	conn.debug("skipped");
+	registry.set_level("db", loggerpp::level::debug);
+	conn.debug("debug");
+	db.trace("skipped");
+	net.info("skipped");
+	net.error("error");
+	EXPECT_TRUE(root.is_enabled(loggerpp::level::trace));
+	root.get_dispatcher()->flush(std::chrono::seconds(10));
+
+	ASSERT_EQ(check.size(), 2);
+	EXPECT_EQ(check[0], "debug@db.conn");
+	EXPECT_EQ(check[1], "error@net");
+}
+
+TEST_F(log_registry_test_suite, load_levels)
+{
+	loggerpp::level_registry registry;
+	const auto root = registry.get_level("");
+	const auto pool = registry.get_level("db.pool");
+
+	std::istringstream config("# levels\n* = error\n db.pool=trace # temporary\n\n");
+	registry.load(config);
+	EXPECT_EQ(root->load(), loggerpp::level::error);
+	EXPECT_EQ(pool->load(), loggerpp::level::trace);
+
+	std::istringstream malformed("db = trace\nnet = verbose\n");
+	EXPECT_THROW(registry.load(malformed), std::invalid_argument);
+	EXPECT_EQ(pool->load(), loggerpp::level::trace);
+}
+
+TEST_F(log_registry_test_suite, watcher_reloads_levels)
+{
+	const std::string path = testing::TempDir() + "loggerpp_levels.conf";
+	std::ofstream(path) << "db = info\n";
+
+	loggerpp::level_registry registry;
+	const auto db = registry.get_level("db");
+	loggerpp::level_config_watcher watcher(path, registry);
+	EXPECT_EQ(db->load(), loggerpp::level::info);
+
+#if defined(__linux__)
+	std::ofstream(path) << "db = debug\n";
+	for (std::size_t attempt = 0; attempt < 500 && db->load() != loggerpp::level::debug; ++attempt)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	EXPECT_EQ(db->load(), loggerpp::level::debug);
+#endif
+	std::remove(path.c_str());
+}
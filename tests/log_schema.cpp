@@ -0,0 +1,243 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/log_schema.h>
+#include <loggerpp/file_log_consumer.h>
+#include <loggerpp/binary_log_consumer.h>
+#include <loggerpp/binary_log_reader.h>
+#include <loggerpp/crash_handler.h>
+#include <loggerpp/flight_recorder.h>
+#include <loggerpp/recent_log_store.h>
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace charivari_ltd;
+
+namespace
+{
+	struct request_context
+	{
+		std::string request_id;
+		std::string tenant;
+		std::int64_t entity = 0;
+
+		static constexpr auto fields()
+		{
+			return std::make_tuple(
+				loggerpp::field("request_id", &request_context::request_id),
+				loggerpp::field("tenant", &request_context::tenant),
+				loggerpp::field("entity", &request_context::entity)
+			);
+		}
+	};
+
+	using request_logger = loggerpp::schema_logger<request_context>;
+	using request_traits = request_logger::traits_t;
+
+	struct numeric_context
+	{
+		int count = 0;
+		float ratio = 0;
+		unsigned short port = 0;
+
+		static constexpr auto fields()
+		{
+			return std::make_tuple(
+				loggerpp::field("count", &numeric_context::count),
+				loggerpp::field("ratio", &numeric_context::ratio),
+				loggerpp::field("port", &numeric_context::port)
+			);
+		}
+	};
+
+	using numeric_traits = loggerpp::schema_log_traits<numeric_context>;
+}
+
+class log_schema_test_suite :
+	public testing::Test
+{
+};
+
+TEST_F(log_schema_test_suite, iterate_fields)
+{
+	static_assert(loggerpp::get_fields_count<request_context>() == 3);
+
+	std::vector<std::string> check;
+	loggerpp::for_each_field(request_context{"r1", "acme", 42}, [&check] (const char* key, const auto& value) {
+		std::ostringstream out;
+		out << key << '=' << value;
+		check.push_back(out.str());
+	});
+	EXPECT_EQ(check, (std::vector<std::string>{"request_id=r1", "tenant=acme", "entity=42"}));
+}
+
+TEST_F(log_schema_test_suite, records_keep_schema)
+{
+	std::vector<request_traits::tags_handle_t> check;
+	{
+		request_logger root;
+		auto x = extend_logger(root, request_context{"r1", "acme", 42});
+		auto y = extend_logger(x, {{"extra", std::int64_t{1}}});
+		auto subscription = root.get_dispatcher()->subscribe([&check] (const auto& tags_handle) {
+			check.push_back(tags_handle);
+		}, loggerpp::ordering::strict);
+		root.info("1");
+		x.info("2");
+		y.warning("3");
+	}
+	ASSERT_EQ(check.size(), 3);
+	EXPECT_EQ(loggerpp::get_schema(check[0]).tenant, "");
+	EXPECT_EQ(loggerpp::get_schema(check[1]).tenant, "acme");
+	EXPECT_EQ(loggerpp::get_schema(check[2]).entity, 42);
+	EXPECT_EQ(get_message(check[2]), "3");
+	EXPECT_EQ(loggerpp::get_tag<std::int64_t>(check[2], "extra"), 1);
+	EXPECT_EQ(check[1].size(), loggerpp::constants::index_guaratee_size);
+}
+
+TEST_F(log_schema_test_suite, write_schema_to_sinks)
+{
+	request_traits::tags_t tags {
+		{std::string("time"), std::chrono::system_clock::time_point(std::chrono::seconds(1))},
+		{std::string("level"), loggerpp::level::info},
+		{std::string("message"), std::string("1")},
+	};
+	tags.schema = {"r1", "acme", 42};
+
+	std::ostringstream out;
+	loggerpp::details::write_text_record<request_traits>(out, tags);
+	EXPECT_NE(out.str().find("\t1\trequest_id=r1\ttenant=acme\tentity=42\n"), std::string::npos);
+
+	const std::string path = "log.lpb";
+	std::remove(path.c_str());
+	{
+		loggerpp::binary_log_writer<request_traits> writer(path);
+		writer.push(tags);
+	}
+	std::vector<logger::tags_t> check;
+	loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(path);
+	reader.read({}, [&check] (const logger::tags_handle_t& record) {
+		check.push_back(record);
+	});
+	std::remove(path.c_str());
+	ASSERT_EQ(check.size(), 1);
+	EXPECT_EQ(loggerpp::get_tag<std::string>(check[0], "tenant"), "acme");
+	EXPECT_EQ(loggerpp::get_tag<std::int64_t>(check[0], "entity"), 42);
+}
+
+TEST_F(log_schema_test_suite, convert_numeric_fields)
+{
+	numeric_traits::tags_t tags {
+		{std::string("time"), std::chrono::system_clock::time_point(std::chrono::seconds(1))},
+		{std::string("level"), loggerpp::level::info},
+		{std::string("message"), std::string("1")},
+	};
+	tags.schema = {-7, 0.5f, 8080};
+
+	std::vector<numeric_traits::value_t> values;
+	loggerpp::details::for_each_schema_tag<numeric_traits::value_t>(tags, [&values] (const char*, const auto& value) {
+		values.push_back(value);
+	});
+	ASSERT_EQ(values.size(), 3);
+	EXPECT_EQ(std::get<std::int64_t>(values[0]), -7);
+	EXPECT_EQ(std::get<double>(values[1]), 0.5);
+	EXPECT_EQ(std::get<std::uint64_t>(values[2]), 8080);
+
+	numeric_traits::tags_t restored;
+	EXPECT_TRUE(loggerpp::details::set_schema_tag(restored, "count", values[0]));
+	EXPECT_TRUE(loggerpp::details::set_schema_tag(restored, "ratio", values[1]));
+	EXPECT_TRUE(loggerpp::details::set_schema_tag(restored, "port", values[2]));
+	EXPECT_EQ(restored.schema.count, -7);
+	EXPECT_EQ(restored.schema.ratio, 0.5f);
+	EXPECT_EQ(restored.schema.port, 8080);
+
+	loggerpp::flight_recorder<numeric_traits> recorder([&restored] (const auto& record) {
+		restored = record;
+	});
+	recorder.push(tags);
+	recorder.dump();
+	EXPECT_EQ(restored.schema.count, -7);
+	EXPECT_EQ(restored.schema.ratio, 0.5f);
+}
+
+TEST_F(log_schema_test_suite, keep_schema_in_stores)
+{
+	request_traits::tags_t tags {
+		{std::string("time"), std::chrono::system_clock::time_point(std::chrono::seconds(1))},
+		{std::string("level"), loggerpp::level::debug},
+		{std::string("message"), std::string("1")},
+		{std::string("extra"), std::int64_t{1}},
+	};
+	tags.schema = {"r1", "acme", 42};
+
+	std::vector<request_traits::tags_t> dumped;
+	loggerpp::flight_recorder<request_traits> recorder([&dumped] (const auto& record) {
+		dumped.push_back(record);
+	});
+	recorder.push(tags);
+	recorder.dump();
+	ASSERT_EQ(dumped.size(), 1);
+	EXPECT_EQ(loggerpp::get_schema(dumped[0]).request_id, "r1");
+	EXPECT_EQ(loggerpp::get_schema(dumped[0]).entity, 42);
+	EXPECT_EQ(dumped[0].size(), 4);
+
+	loggerpp::recent_log_store<request_traits> store;
+	store.push(tags);
+	loggerpp::recent_log_query<request_traits::value_t> query;
+	query.tags = {{"tenant", std::string("acme")}};
+	const auto found = store.query(query);
+	ASSERT_EQ(found.size(), 1);
+	EXPECT_EQ(loggerpp::get_schema(found[0]).tenant, "acme");
+	EXPECT_EQ(loggerpp::get_schema(found[0]).entity, 42);
+	EXPECT_EQ(loggerpp::get_tag<std::int64_t>(found[0], "extra"), 1);
+
+	const std::string path = "crash.log";
+	const auto fd = ::open(path.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	{
+		loggerpp::details::signal_safe_writer out(fd);
+		loggerpp::details::write_signal_safe_tags<request_traits>(out, tags);
+	}
+	::close(fd);
+	std::ifstream file(path);
+	std::string line;
+	std::getline(file, line);
+	EXPECT_NE(line.find("\t1\textra=1\trequest_id=r1\ttenant=acme\tentity=42"), std::string::npos);
+	std::remove(path.c_str());
+}
@@ -32,9 +32,14 @@
 //
 
 #include <loggerpp/logger.h>
+#include <loggerpp/metrics_reporter.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <future>
+#include <sstream>
+
 using namespace charivari_ltd;
 
 class logger_test_suite :
@@ -74,6 +79,69 @@ TEST_F(logger_test_suite, log_without_consumer)
 	root.debug("Test");
 }
 
+TEST_F(logger_test_suite, dispatcher_starts_on_subscribe)
+{
+	std::vector<std::string> check;
+	logger root;
+	root.info("before");
+	EXPECT_FALSE(root.get_dispatcher()->is_started());
+	{
+		auto subscription = root >> [&check] (const auto& tags) {
+			check.push_back(get_message(tags));
+		};
+		EXPECT_TRUE(root.get_dispatcher()->is_started());
+		root.info("after");
+	}
+	ASSERT_EQ(check.size(), 1);
+	EXPECT_EQ(check[0], "after");
+}
+
+TEST_F(logger_test_suite, dispatchers_share_worker)
+{
+	loggerpp::dispatcher_options options;
+	options.shared_worker = true;
+
+	std::vector<std::string> check1;
+	std::vector<std::string> check2;
+	{
+		logger root1(std::make_shared<logger::dispatcher_t>(options), {});
+		logger root2(std::make_shared<logger::dispatcher_t>(options), {});
+		auto subscription1 = root1 >> [&check1] (const auto& tags) {
+			check1.push_back(get_message(tags));
+		};
+		auto subscription2 = root2 >> [&check2] (const auto& tags) {
+			check2.push_back(get_message(tags));
+		};
+		for (std::size_t index = 0; index < 100; ++index)
+		{
+			root1.info("1");
+			root2.info("2");
+		}
+	}
+	EXPECT_EQ(check1, std::vector<std::string>(100, "1"));
+	EXPECT_EQ(check2, std::vector<std::string>(100, "2"));
+}
+
+TEST_F(logger_test_suite, shared_worker_task_releases_dispatcher)
+{
+	loggerpp::dispatcher_options options;
+	options.shared_worker = true;
+
+	auto other = std::make_unique<logger>(std::make_shared<logger::dispatcher_t>(options), logger::tags_t{});
+	{
+		auto subscription = *other >> [] (const auto&) {};
+		other->info("1");
+	}
+	std::promise<void> released;
+	logger root(std::make_shared<logger::dispatcher_t>(options), {});
+	auto subscription = root >> [&other, &released] (const auto&) {
+		other.reset();
+		released.set_value();
+	};
+	root.info("release");
+	EXPECT_EQ(released.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+}
+
 TEST_F(logger_test_suite, log_messages_with_consumer)
 {
 	std::vector<std::string> check;
@@ -119,6 +187,564 @@ TEST_F(logger_test_suite, log_two_consumers)
 	EXPECT_EQ(check2[0], "2");
 }
 
+TEST_F(logger_test_suite, critical_overtakes_debug_backlog)
+{
+	std::vector<std::string> check;
+	std::promise<void> entered;
+	std::promise<void> unblock;
+	auto blocked = unblock.get_future().share();
+	logger root;
+	{
+		auto subscription = root >> [&check, &entered, blocked] (const auto& tags) {
+			if (check.empty())
+				entered.set_value();
+			blocked.wait();
+			check.push_back(get_message(tags));
+		};
+		//the dispatcher thread is busy with the first record while the backlog is queued
+		root.debug("first");
+		entered.get_future().wait();
+		for (std::size_t index = 0; index < 100; ++index)
+			root.debug("debug");
+		root.critical("critical");
+		unblock.set_value();
+	}
+	ASSERT_EQ(check.size(), 102);
+	EXPECT_EQ(check[0], "first");
+	EXPECT_EQ(check[1], "critical");
+	for (std::size_t index = 2; index < check.size(); ++index)
+		EXPECT_EQ(check[index], "debug");
+}
+
+TEST_F(logger_test_suite, strict_ordering_passes_held_records_on_unsubscribe)
+{
+	std::vector<std::string> check;
+	std::promise<void> entered;
+	std::promise<void> unblock;
+	auto blocked = unblock.get_future().share();
+	logger root;
+	std::thread unblocker;
+	{
+		auto subscription = root.get_dispatcher()->subscribe([&check, &entered, blocked] (const auto& tags) {
+			if (check.empty())
+				entered.set_value();
+			blocked.wait();
+			check.push_back(get_message(tags));
+		}, loggerpp::ordering::strict);
+		root.debug("first");
+		entered.get_future().wait();
+		//more than the drain task takes at once, so unsubscribe may come between drain tasks
+		for (std::size_t index = 0; index < 2000; ++index)
+			root.debug("debug");
+		root.critical("critical");
+		//unsubscribe starts while the critical record is not passed yet
+		unblocker = std::thread([&unblock] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			unblock.set_value();
+		});
+	}
+	unblocker.join();
+	ASSERT_EQ(check.size(), 2002);
+	EXPECT_EQ(check.back(), "critical");
+}
+
+TEST_F(logger_test_suite, strict_ordering_keeps_push_order)
+{
+	std::vector<std::string> check;
+	std::promise<void> unblock;
+	auto blocked = unblock.get_future().share();
+	logger root;
+	{
+		auto subscription = root.get_dispatcher()->subscribe([&check, blocked] (const auto& tags) {
+			blocked.wait();
+			check.push_back(get_message(tags));
+		}, loggerpp::ordering::strict);
+		for (std::size_t index = 0; index < 100; ++index)
+			root.debug("{}", index);
+		root.critical("critical");
+		unblock.set_value();
+	}
+	ASSERT_EQ(check.size(), 101);
+	for (std::size_t index = 0; index < 100; ++index)
+		EXPECT_EQ(check[index], std::to_string(index));
+	EXPECT_EQ(check.back(), "critical");
+}
+
+TEST_F(logger_test_suite, check_wait_strategies)
+{
+	for (auto strategy : {loggerpp::wait_strategy::busy_spin, loggerpp::wait_strategy::spin_yield, loggerpp::wait_strategy::blocking, loggerpp::wait_strategy::adaptive})
+	{
+		loggerpp::dispatcher_options options;
+		options.worker.wait = strategy;
+		options.worker.wakeup_delay = std::chrono::microseconds{100};
+
+		std::vector<std::string> check;
+		logger root(std::make_shared<logger::dispatcher_t>(options), {});
+		{
+			auto subscription = root >> [&check] (const auto& tags) {
+				check.push_back(get_message(tags));
+			};
+			for (std::size_t index = 0; index < 100; ++index)
+			{
+				root.info("{}", index);
+				if (index % 10 == 0)
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		ASSERT_EQ(check.size(), 100);
+		for (std::size_t index = 0; index < 100; ++index)
+			EXPECT_EQ(check[index], std::to_string(index));
+	}
+}
+
+#if defined(__linux__)
+TEST_F(logger_test_suite, check_thread_options)
+{
+	loggerpp::dispatcher_options options;
+	options.worker.thread.name = "loggerpp_test_dispatcher";
+	options.worker.thread.affinity = {0};
+
+	std::string name;
+	bool started = false;
+	options.worker.thread.on_start = [&started] {
+		started = true;
+	};
+
+	logger root(std::make_shared<logger::dispatcher_t>(options), {});
+	{
+		auto subscription = root >> [&name] (const auto&) {
+			char buffer[16] = {};
+			::pthread_getname_np(::pthread_self(), buffer, sizeof(buffer));
+			name = buffer;
+		};
+		root.info("test");
+	}
+	EXPECT_TRUE(started);
+	EXPECT_EQ(name, "loggerpp_test_d");
+}
+#endif
+
+#if defined(__linux__)
+TEST_F(logger_test_suite, failed_thread_options_are_reported)
+{
+	loggerpp::dispatcher_options options;
+	options.worker.thread.name = "loggerpp_hints";
+	options.worker.thread.policy = SCHED_FIFO;
+	options.worker.thread.priority = 1000;	//out of range for any policy
+	options.worker.thread.affinity = {0, CPU_SETSIZE};
+
+	std::vector<std::string> errors;
+	options.worker.thread.on_error = [&errors] (const std::system_error& e) {
+		errors.push_back(e.what());
+	};
+
+	std::string name;
+	logger root(std::make_shared<logger::dispatcher_t>(options), {});
+	{
+		auto subscription = root >> [&name] (const auto&) {
+			char buffer[16] = {};
+			::pthread_getname_np(::pthread_self(), buffer, sizeof(buffer));
+			name = buffer;
+		};
+		root.info("test");
+	}
+	ASSERT_EQ(errors.size(), 2);
+	EXPECT_NE(errors[0].find("CPU_SET"), std::string::npos);
+	EXPECT_NE(errors[1].find("pthread_setschedparam"), std::string::npos);
+	EXPECT_EQ(name, "loggerpp_hints");
+}
+#endif
+
+TEST_F(logger_test_suite, sync_logger_calls_consumer_inline)
+{
+	std::vector<std::string> check;
+	sync_logger root;
+	root.debug("1");
+	{
+		const auto thread_id = std::this_thread::get_id();
+		auto subscription = root >> [&check, thread_id] (const auto& tags) {
+			EXPECT_EQ(std::this_thread::get_id(), thread_id);
+			check.push_back(get_message(tags));
+		};
+		root.debug("2");
+		EXPECT_EQ(check.size(), 1);
+	}
+	root.debug("3");
+	ASSERT_EQ(check.size(), 1);
+	EXPECT_EQ(check[0], "2");
+}
+
+TEST_F(logger_test_suite, sync_logger_reentrant_consumer)
+{
+	std::vector<std::string> check;
+	sync_logger root;
+	{
+		auto subscription = root >> [&check, &root] (const auto& tags) {
+			const auto message = get_message(tags);
+			if (message == "outer")
+				root.info("inner");
+			check.push_back(message);
+		};
+		root.info("outer");
+	}
+	ASSERT_EQ(check.size(), 2);
+	EXPECT_EQ(check[0], "outer");
+	EXPECT_EQ(check[1], "inner");
+}
+
+TEST_F(logger_test_suite, sync_logger_consumer_drops_own_subscription)
+{
+	std::size_t count = 0;
+	std::vector<std::string> check;
+	sync_logger root;
+	auto other = root >> [&check] (const auto& tags) {
+		check.push_back(get_message(tags));
+	};
+	std::shared_ptr<sync_logger::dispatcher_t::consumer_fn> subscription;
+	subscription = root >> [&count, &subscription] (const auto&) {
+		++count;
+		subscription.reset();
+	};
+	root.info("1");
+	root.info("2");
+	EXPECT_EQ(subscription, nullptr);
+	EXPECT_EQ(count, 1);
+	EXPECT_EQ(check, (std::vector<std::string>{"1", "2"}));
+}
+
+TEST_F(logger_test_suite, sync_logger_passes_consumer_exception_to_handler)
+{
+	std::size_t handled = 0;
+	std::vector<std::string> check;
+	sync_logger root(std::make_shared<sync_logger::dispatcher_t>([&handled] (std::exception_ptr) {
+		++handled;
+	}, loggerpp::sync_log_traits::get_dispatcher_options()), {});
+	auto failed = root >> [] (const auto&) {
+		throw std::runtime_error("consumer");
+	};
+	auto subscription = root >> [&check] (const auto& tags) {
+		check.push_back(get_message(tags));
+	};
+	EXPECT_NO_THROW(root.info("1"));
+	EXPECT_EQ(handled, 1);
+	EXPECT_EQ(check, (std::vector<std::string>{"1"}));
+
+	sync_logger by_default;
+	auto throwing = by_default >> [] (const auto&) {
+		throw std::runtime_error("consumer");
+	};
+	EXPECT_NO_THROW(by_default.info("1"));
+}
+
+TEST_F(logger_test_suite, sync_logger_drops_records_of_failed_consumer)
+{
+	std::vector<std::string> check;
+	sync_logger root(std::make_shared<sync_logger::dispatcher_t>([] (std::exception_ptr ptr) {
+		std::rethrow_exception(ptr);
+	}, loggerpp::sync_log_traits::get_dispatcher_options()), {});
+	{
+		auto subscription = root >> [&check, &root] (const auto& tags) {
+			const auto message = get_message(tags);
+			check.push_back(message);
+			if (message == "outer")
+			{
+				root.info("inner");
+				throw std::runtime_error("consumer");
+			}
+		};
+		EXPECT_NO_THROW(root.info("outer"));
+		root.info("next");
+	}
+	EXPECT_EQ(check, (std::vector<std::string>{"outer", "next"}));
+}
+
+TEST_F(logger_test_suite, dispatch_after_exception_of_handler)
+{
+	std::atomic<std::size_t> handled {0};
+	std::vector<std::string> check;
+	logger root(std::make_shared<logger::dispatcher_t>([&handled] (std::exception_ptr ptr) {
+		//the first exception escapes the handler; the worker passes it to the handler again
+		if (handled++ == 0)
+			std::rethrow_exception(ptr);
+	}), {});
+	auto subscription = root >> [&check] (const auto& tags) {
+		const auto message = get_message(tags);
+		if (message == "throw")
+			throw std::runtime_error("consumer");
+		check.push_back(message);
+	};
+	root.info("1");
+	root.info("throw");
+	root.info("2");
+	ASSERT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+	root.info("3");
+	ASSERT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+	EXPECT_EQ(handled.load(), 2);
+	EXPECT_EQ(check, (std::vector<std::string>{"1", "2", "3"}));
+}
+
+TEST_F(logger_test_suite, render_once_for_text_consumers)
+{
+	struct format {};
+	std::atomic_int renders {0};
+	std::ostringstream out1, out2;
+	const auto make_consumer = [&renders] (std::ostream& out) {
+		return loggerpp::details::make_text_consumer([&renders, &out] (const logger::tags_handle_t& tags) {
+			loggerpp::details::write_rendered<loggerpp::default_log_traits, format>(out, tags, [&renders, &tags] (std::ostream& text) {
+				++renders;
+				text << get_message(tags) << std::endl;
+			});
+		});
+	};
+
+	logger root;
+	auto subscription1 = root >> make_consumer(out1);
+	auto subscription2 = root >> make_consumer(out2);
+	root.info("1");
+	root.info("2");
+	ASSERT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+	EXPECT_EQ(renders.load(), 2);
+	EXPECT_EQ(out1.str(), "1\n2\n");
+	EXPECT_EQ(out2.str(), "1\n2\n");
+}
+
+TEST_F(logger_test_suite, check_metrics)
+{
+	metrics_logger root(std::make_shared<metrics_logger::dispatcher_t>([] (std::exception_ptr) {}), {});
+	root.info("undelivered");
+	{
+		auto subscription = root >> [] (const auto& tags) {
+			if (get_message(tags) == "throw")
+				throw std::runtime_error("consumer");
+		};
+		auto fast = root >> [] (const auto&) {};
+		EXPECT_EQ(root.get_dispatcher()->get_metrics().consumers.size(), 2);
+		for (std::size_t index = 0; index < 10; ++index)
+			root.info("{}", index);
+		root.info("throw");
+	}
+	root.info("undelivered");
+	root.get_dispatcher()->flush(std::chrono::seconds(10));
+	root.get_dispatcher()->shutdown(std::chrono::seconds(10));
+	root.info("dropped");
+
+	const auto metrics = root.get_dispatcher()->get_metrics();
+	EXPECT_EQ(metrics.pushed, 12);
+	EXPECT_EQ(metrics.dispatched, 12);
+	EXPECT_EQ(metrics.queue_depth, 0);
+	EXPECT_GE(metrics.queue_depth_high_water, 1);
+	EXPECT_EQ(metrics.exceptions, 1);
+	EXPECT_EQ(metrics.dropped, 1);
+	EXPECT_EQ(metrics.undelivered, 2);
+	EXPECT_EQ(metrics.push_to_dispatch.count, 12);
+	EXPECT_EQ(metrics.consumer_call.count, 22);
+	EXPECT_TRUE(metrics.consumers.empty());
+	EXPECT_LE(metrics.push_to_dispatch.percentile(0.5), metrics.push_to_dispatch.max);
+}
+
+TEST_F(logger_test_suite, snapshot_metrics_while_subscribe)
+{
+	metrics_logger root;
+	std::atomic_bool done {false};
+	std::thread reader([&root, &done] {
+		while (!done)
+			EXPECT_LE(root.get_dispatcher()->get_metrics().consumers.size(), 2);
+	});
+	auto subscription = root >> [] (const auto&) {};
+	for (std::size_t index = 0; index < 100; ++index)
+	{
+		auto other = root >> [] (const auto&) {};
+		root.info("1");
+	}
+	done = true;
+	reader.join();
+	EXPECT_EQ(root.get_dispatcher()->get_metrics().consumers.size(), 1);
+}
+
+TEST_F(logger_test_suite, check_log_metrics)
+{
+	std::vector<logger::tags_t> check;
+	metrics_logger root;
+	{
+		auto subscription = root >> [&check] (const auto& tags) {
+			check.push_back(tags);
+		};
+		root.info("1");
+		root.get_dispatcher()->flush(std::chrono::seconds(10));
+		loggerpp::log_metrics(root);
+	}
+	ASSERT_EQ(check.size(), 2);
+	EXPECT_EQ(get_message(check[1]), loggerpp::constants::metrics_message);
+	EXPECT_EQ(loggerpp::get_tag<std::uint64_t>(check[1], "pushed"), 1);
+	EXPECT_EQ(loggerpp::get_tag<std::uint64_t>(check[1], "consumer_0_call_max_ns"), loggerpp::get_tag<std::uint64_t>(check[1], "consumer_call_max_ns"));
+}
+
+TEST_F(logger_test_suite, check_disabled_metrics)
+{
+	logger root;
+	root.info("1");
+	EXPECT_EQ(root.get_dispatcher()->get_metrics().pushed, 0);
+}
+
+TEST_F(logger_test_suite, flush_waits_for_consumers)
+{
+	std::vector<std::string> check;
+	bool flushed = false;
+	logger root;
+	auto subscription = root.get_dispatcher()->subscribe([&check] (const auto& tags) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		check.push_back(get_message(tags));
+	}, [&flushed, &check] {
+		flushed = check.size() == 10;
+	});
+	for (std::size_t index = 0; index < 10; ++index)
+		root.debug("{}", index);
+
+	EXPECT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+	EXPECT_EQ(check.size(), 10);
+	EXPECT_TRUE(flushed);
+}
+
+TEST_F(logger_test_suite, lower_lane_is_not_starved)
+{
+	std::vector<loggerpp::level> check;
+	std::promise<void> entered;
+	std::promise<void> unblock;
+	auto blocked = unblock.get_future().share();
+	logger root;
+	auto subscription = root >> [&check, &entered, blocked] (const auto& tags) {
+		if (check.empty())
+		{
+			entered.set_value();
+			blocked.wait();
+		}
+		check.push_back(*loggerpp::get_tag<loggerpp::level>(tags, "level"));
+	};
+	root.info("first");
+	entered.get_future().wait();
+
+	root.debug("debug");
+	const std::size_t errors = 64 * 16;
+	for (std::size_t index = 0; index < errors; ++index)
+		root.error("{}", index);
+	unblock.set_value();
+	ASSERT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+
+	ASSERT_EQ(check.size(), errors + 2);
+	const auto debug = std::find(check.begin(), check.end(), loggerpp::level::debug) - check.begin();
+	EXPECT_EQ(debug, 1 + 64 * 8);
+}
+
+TEST_F(logger_test_suite, flush_returns_on_deadline)
+{
+	std::promise<void> unblock;
+	auto blocked = unblock.get_future().share();
+	logger root;
+	auto subscription = root >> [blocked] (const auto&) {
+		blocked.wait();
+	};
+	root.debug("1");
+
+	EXPECT_FALSE(root.get_dispatcher()->flush(std::chrono::milliseconds(10)));
+	unblock.set_value();
+	EXPECT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+}
+
+TEST_F(logger_test_suite, shutdown_reports_dropped)
+{
+	std::vector<std::string> check;
+	std::promise<void> unblock;
+	auto blocked = unblock.get_future().share();
+	logger root;
+	{
+		auto subscription = root >> [&check, blocked] (const auto& tags) {
+			blocked.wait();
+			check.push_back(get_message(tags));
+		};
+		for (std::size_t index = 0; index < 200; ++index)
+			root.debug("{}", index);
+
+		//shutdown waits for the batch being dispatched after deadline
+		auto shutdown = std::async(std::launch::async, [&root] {
+			return root.get_dispatcher()->shutdown(std::chrono::milliseconds(10));
+		});
+		EXPECT_EQ(shutdown.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+		unblock.set_value();
+		const auto dropped = shutdown.get();
+		const auto passed = check.size();
+		EXPECT_GT(dropped, 0);
+		EXPECT_EQ(passed + dropped, 200);
+
+		root.debug("after shutdown");
+		EXPECT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+		EXPECT_EQ(check.size(), passed);
+	}
+	EXPECT_EQ(std::count(check.begin(), check.end(), "after shutdown"), 0);
+}
+
+TEST_F(logger_test_suite, shutdown_drops_records_held_by_strict_subscription)
+{
+	std::vector<std::string> check;
+	std::promise<void> entered_first;
+	std::promise<void> entered_critical;
+	std::promise<void> unblock_first;
+	std::promise<void> unblock_critical;
+	metrics_logger root(std::make_shared<metrics_logger::dispatcher_t>([] (std::exception_ptr) {}), {});
+	{
+		auto strict = root.get_dispatcher()->subscribe([&check] (const auto& tags) {
+			check.push_back(get_message(tags));
+		}, loggerpp::ordering::strict);
+		//the relaxed consumer keeps the critical record in flight while shutdown drops the debug backlog
+		auto blocker = root >> [&] (const auto& tags) {
+			if (get_message(tags) == "first")
+			{
+				entered_first.set_value();
+				unblock_first.get_future().wait();
+			}
+			if (get_message(tags) == "critical")
+			{
+				entered_critical.set_value();
+				unblock_critical.get_future().wait();
+			}
+		};
+		root.debug("first");
+		entered_first.get_future().wait();
+		for (std::size_t index = 0; index < 100; ++index)
+			root.debug("debug");
+		root.critical("critical");
+		unblock_first.set_value();
+		entered_critical.get_future().wait();
+
+		auto shutdown = std::async(std::launch::async, [&root] {
+			return root.get_dispatcher()->shutdown(std::chrono::milliseconds(10));
+		});
+		while (root.get_dispatcher()->get_metrics().dropped < 100)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		unblock_critical.set_value();
+
+		//the critical record held by the strict subscription is dropped after the deadline, but it's counted
+		EXPECT_EQ(shutdown.get(), 101);
+		EXPECT_EQ(root.get_dispatcher()->get_metrics().dropped, 101);
+		EXPECT_EQ(root.get_dispatcher()->get_metrics().queue_depth, 0);
+		EXPECT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+	}
+	EXPECT_EQ(check, (std::vector<std::string>{"first"}));
+}
+
+TEST_F(logger_test_suite, flush_called_by_consumer_returns_false)
+{
+	std::promise<bool> flushed;
+	auto result = flushed.get_future();
+	logger root;
+	auto subscription = root >> [&root, &flushed] (const auto&) {
+		flushed.set_value(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+	};
+	const auto start = std::chrono::steady_clock::now();
+	root.info("flush");
+	EXPECT_FALSE(result.get());
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
 TEST_F(logger_test_suite, check_extend_tags)
 {
 	logger root;
@@ -290,6 +916,153 @@ TEST_F(logger_test_suite, check_formatter_ex)
 	EXPECT_EQ(check[0], "AAA BBB CCC");
 }
 
+TEST_F(logger_test_suite, check_formatter_lazy)
+{
+	std::size_t calls = 0;
+	const auto dump_state = [&calls] {
+		++calls;
+		return std::string{"state"};
+	};
+
+	std::vector<std::string> check;
+	loggerpp::level_registry registry;
+	logger root;
+	auto named = loggerpp::get_logger(root, "lazy", registry);
+	named.debug("{}", loggerpp::lazy(dump_state));
+	{
+		auto subscription = root >> [&check] (const auto& tags) {
+			check.push_back(get_message(tags));
+		};
+		registry.set_level("lazy", loggerpp::level::info);
+		named.debug("{}", loggerpp::lazy(dump_state));
+		named.info("{} {}", loggerpp::lazy(dump_state), loggerpp::lazy([] { return 42; }));
+	}
+	EXPECT_EQ(calls, 1);
+	ASSERT_EQ(check.size(), 1);
+	EXPECT_EQ(check[0], "state 42");
+}
+
+TEST_F(logger_test_suite, check_stream)
+{
+	std::size_t calls = 0;
+	const auto nested = [&calls] (const logger& ref) {
+		++calls;
+		ref.error() << "nested " << 1;
+		return "outer";
+	};
+
+	std::vector<std::string> check;
+	loggerpp::level_registry registry;
+	logger root;
+	auto named = loggerpp::get_logger(root, "stream", registry);
+	named.info() << "not started";
+	{
+		auto subscription = root.get_dispatcher()->subscribe([&check] (const auto& tags) {
+			check.push_back(get_message(tags));
+		}, loggerpp::ordering::strict);
+		registry.set_level("stream", loggerpp::level::info);
+		named.debug() << "disabled";
+		named.info() << "x=" << 42 << ", y=" << -1.5 << ", " << 1e20 << ", " << 0.25f << ", " << 1e100 << ", " << true << ' ' << std::string{"s"} << ' ' << std::uint64_t{7} << ' ' << L'w' << u'\u00e9' << U'\u20ac';
+		root.warning() << nested(root);
+		try {
+			root.info() << "interrupted" << [] () -> int { throw std::runtime_error("arg"); }();
+		} catch (const std::runtime_error&) {
+		}
+		root.info() << "after";
+	}
+	EXPECT_EQ(calls, 1);
+	ASSERT_EQ(check.size(), 4);
+	EXPECT_EQ(check[0], "x=42, y=-1.500000, 100000000000000000000.000000, 0.250000, " + std::to_string(1e100) + ", true s 7 w\xc3\xa9\xe2\x82\xac");
+	EXPECT_EQ(check[1], "nested 1");
+	EXPECT_EQ(check[2], "outer");
+	EXPECT_EQ(check[3], "after");
+}
+
+TEST_F(logger_test_suite, check_stream_reuses_buffer)
+{
+	std::vector<std::string> check;
+	const std::string text(1000, 'x');
+	logger root;
+	{
+		auto subscription = root.get_dispatcher()->subscribe([&check] (const auto& tags) {
+			check.push_back(get_message(tags));
+		}, loggerpp::ordering::strict);
+		root.info() << text << 1;
+		root.info() << "short";
+		root.info() << text;
+	}
+	ASSERT_EQ(check.size(), 3);
+	EXPECT_EQ(check[0], text + "1");
+	EXPECT_EQ(check[1], "short");
+	EXPECT_EQ(check[2], text);
+}
+
+TEST_F(logger_test_suite, check_site)
+{
+	std::vector<logger::tags_t> check;
+	loggerpp::level_registry registry;
+	logger root;
+	auto named = loggerpp::get_logger(root, "site", registry) | logger::tag_t{"id", 1};
+	{
+		auto subscription = root.get_dispatcher()->subscribe([&check] (const auto& tags) {
+			check.push_back(tags);
+		}, loggerpp::ordering::strict);
+		registry.set_level("site", loggerpp::level::info);
+		for (int index = 0; index < 2; ++index)
+			LOGGERPP_LOG(named, loggerpp::level::info, "connected to {}:{} {}", std::string{"host"}, 8080 + index, loggerpp::lazy([] { return 7; }));
+		LOGGERPP_LOG(named, loggerpp::level::debug, "disabled");
+		LOGGERPP_LOG(named, loggerpp::level::warning, "no args");
+	}
+
+	ASSERT_EQ(check.size(), 3);
+	EXPECT_EQ(get_message(check[0]), "connected to host:8080 7");
+	EXPECT_EQ(get_message(check[1]), "connected to host:8081 7");
+	EXPECT_EQ(get_message(check[2]), "no args");
+	EXPECT_EQ(loggerpp::get_wmessage(check[0]), L"connected to host:8080 7");
+	EXPECT_EQ(loggerpp::get_wmessage(check[2]), L"no args");
+	EXPECT_EQ(loggerpp::get_site_args_count(check[0]), 3);
+	EXPECT_EQ(loggerpp::get_tag<std::int64_t>(check[0], "id"), 1);
+	EXPECT_EQ(loggerpp::get_tag<std::int64_t>(check[1], "1"), 8081);
+
+	const auto id = loggerpp::get_tag<std::uint64_t>(check[0], loggerpp::constants::key_site);
+	ASSERT_TRUE(id);
+	EXPECT_EQ(id, loggerpp::get_tag<std::uint64_t>(check[1], loggerpp::constants::key_site));
+	const auto site = loggerpp::sites().find(*id);
+	ASSERT_NE(site, nullptr);
+	EXPECT_EQ(site->lvl, loggerpp::level::info);
+	EXPECT_EQ(std::string{site->format}, "connected to {}:{} {}");
+	EXPECT_EQ(std::string{site->function}, "TestBody");
+	EXPECT_NE(std::string{site->file}.find("logger.cpp"), std::string::npos);
+	EXPECT_EQ(site->args_count, 3);
+}
+
+TEST_F(logger_test_suite, message_of_integer_is_not_site)
+{
+	loggerpp::sites().add(loggerpp::level::info, "site {}", __FILE__, __LINE__, __func__, 1);
+	const logger::tags_t tags {
+		{"time", std::chrono::system_clock::now()},
+		{"level", loggerpp::level::info},
+		{"message", std::uint64_t{0}},
+		{"0", std::int64_t{1}},
+	};
+	EXPECT_EQ(loggerpp::get_site_id(tags), nullptr);
+	EXPECT_EQ(loggerpp::get_site_args_count(tags), 0);
+
+	std::ostringstream out;
+	loggerpp::details::write_text_head<loggerpp::default_log_traits>(out, tags);
+	EXPECT_EQ(out.str().substr(out.str().size() - 7), "\tinfo\t0");
+}
+
+TEST_F(logger_test_suite, find_sites_after_growth)
+{
+	std::vector<const loggerpp::log_site*> added;
+	for (std::size_t index = 0; index < 300; ++index)
+		added.push_back(&loggerpp::sites().add(loggerpp::level::info, "grown", __FILE__, __LINE__, __func__, index));
+	for (const auto site : added)
+		EXPECT_EQ(loggerpp::sites().find(site->id), site);
+	EXPECT_EQ(loggerpp::sites().find(added.back()->id + 1), nullptr);
+}
+
 TEST_F(logger_test_suite, check_default_consumer)
 {
 	logger root;
@@ -304,6 +1077,8 @@ TEST_F(logger_test_suite, check_default_consumer)
 			.error("fail");
 	}
 
+	void (*consumer)(const logger::tags_handle_t&) = &loggerpp::default_consumer;
+	EXPECT_NE(consumer, nullptr);
 }
 
 TEST_F(logger_test_suite, check_not_found_tag)
@@ -0,0 +1,171 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/recent_log_store.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace charivari_ltd;
+
+class recent_log_store_test_suite :
+	public testing::Test
+{
+public:
+	using store_t = loggerpp::recent_log_store<loggerpp::default_log_traits>;
+	using query_t = store_t::query_t;
+
+	static logger::tags_handle_t make_record(int seconds, loggerpp::level lvl, const std::string& message, const std::string& user)
+	{
+		return {
+			{std::string("time"), start + std::chrono::seconds(seconds)},
+			{std::string("level"), lvl},
+			{std::string("message"), message},
+			{std::string("user"), user},
+			{std::wstring(L"id"), std::int64_t{seconds}},
+		};
+	}
+
+	static std::vector<std::string> get_messages(const std::vector<logger::tags_t>& records)
+	{
+		std::vector<std::string> messages;
+		for (const auto& tags : records)
+			messages.push_back(get_message(tags));
+		return messages;
+	}
+
+public:
+	static inline const std::chrono::system_clock::time_point start = std::chrono::system_clock::time_point(std::chrono::hours(24 * 365 * 50));
+};
+
+TEST_F(recent_log_store_test_suite, query_by_columns)
+{
+	store_t store({4, 8, 1 << 20});
+	for (int index = 0; index < 40; ++index)
+		store.push(make_record(index, index % 3 == 0 ? loggerpp::level::error : loggerpp::level::info, "m" + std::to_string(index), index % 2 ? "odd" : "even"));
+	EXPECT_EQ(store.get_records_count(), 32);
+
+	EXPECT_EQ(get_messages(store.query({})).front(), "m8");
+
+	query_t query;
+	query.from = start + std::chrono::seconds(20);
+	query.to = start + std::chrono::seconds(30);
+	query.levels = {loggerpp::level::error};
+	EXPECT_EQ(get_messages(store.query(query)), (std::vector<std::string>{"m21", "m24", "m27"}));
+
+	query.tags = {{"user", std::string("odd")}};
+	EXPECT_EQ(get_messages(store.query(query)), (std::vector<std::string>{"m21", "m27"}));
+
+	query.tags = {{"user", std::string("nobody")}};
+	EXPECT_TRUE(store.query(query).empty());
+
+	query = {};
+	query.limit = 2;
+	EXPECT_EQ(get_messages(store.query(query)), (std::vector<std::string>{"m38", "m39"}));
+}
+
+TEST_F(recent_log_store_test_suite, restore_tags)
+{
+	store_t store;
+	store.push(make_record(5, loggerpp::level::warning, "w", "root"));
+	const auto records = store.query({});
+	ASSERT_EQ(records.size(), 1);
+	const auto& tags = records.front();
+	EXPECT_EQ(loggerpp::get_time(tags), start + std::chrono::seconds(5));
+	EXPECT_EQ(loggerpp::get_level(tags), loggerpp::level::warning);
+	EXPECT_EQ(get_message(tags), "w");
+	EXPECT_EQ(loggerpp::get_tag<std::string>(tags, "user"), "root");
+	EXPECT_EQ(loggerpp::get_tag<std::int64_t>(tags, L"id"), 5);
+}
+
+TEST_F(recent_log_store_test_suite, store_rendered_site_message)
+{
+	const auto& site = loggerpp::sites().add(loggerpp::level::info, "{} + {}", __FILE__, __LINE__, __func__, 2);
+	store_t store;
+	store.push(logger::tags_handle_t{
+		{std::string("time"), start},
+		{std::string("level"), loggerpp::level::info},
+		{std::string("site"), site.id},
+		{std::string("user"), std::string("root")},
+		{std::string("0"), std::int64_t{1}},
+		{std::string("1"), std::int64_t{2}},
+	});
+
+	const auto found = store.query({});
+	ASSERT_EQ(found.size(), 1);
+	EXPECT_EQ(get_message(found[0]), "1 + 2");
+	EXPECT_EQ(loggerpp::get_tag<std::string>(found[0], "user"), "root");
+	EXPECT_FALSE(loggerpp::get_vtag(found[0], std::string("0")));
+	EXPECT_EQ(found[0].size(), 4);
+}
+
+TEST_F(recent_log_store_test_suite, evict_by_bytes)
+{
+	store_t store({16, 1000, 8192});
+	for (int index = 0; index < 1000; ++index)
+		store.push(make_record(index, loggerpp::level::info, std::string(64, 'x'), std::to_string(index)));
+	const auto count = store.get_records_count();
+	EXPECT_LT(count, 1000);
+	EXPECT_EQ(count % 16, 1000 % 16);
+	EXPECT_EQ(loggerpp::get_tag<std::int64_t>(store.query({}).front(), L"id"), 1000 - count);
+}
+
+TEST_F(recent_log_store_test_suite, seal_chunk_by_bytes)
+{
+	store_t store({1 << 16, 32, 8192});
+	for (int index = 0; index < 1000; ++index)
+		store.push(make_record(index, loggerpp::level::info, std::string(64, 'x'), std::to_string(index)));
+	const auto count = store.get_records_count();
+	EXPECT_GT(count, 0);
+	EXPECT_LT(count, 100);
+	EXPECT_EQ(loggerpp::get_tag<std::int64_t>(store.query({}).back(), L"id"), 999);
+
+	EXPECT_THROW(store_t({16, 0, 8192}), std::invalid_argument);
+}
+
+TEST_F(recent_log_store_test_suite, store_with_logger)
+{
+	auto store = std::make_shared<store_t>();
+	{
+		logger root;
+		auto subscription = root.get_dispatcher()->subscribe(loggerpp::build_recent_log_consumer(store), loggerpp::ordering::strict);
+		root.info("i1");
+		root.error("e1");
+	}
+	query_t query;
+	query.levels = {loggerpp::level::error, loggerpp::level::critical};
+	EXPECT_EQ(get_messages(store->query(query)), (std::vector<std::string>{"e1"}));
+}
@@ -36,11 +36,44 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
 using namespace charivari_ltd;
 
 class shared_tags_logger_test_suite :
 	public testing::Test
 {
+public:
+	//wrap makes a consumer with own queue of the slow consumer
+	template <typename wrap_t>
+	static void check_flush_and_shutdown_of_queued_consumer(wrap_t&& wrap)
+	{
+		std::atomic<std::size_t> consumed {0};
+		shared_tags_logger root;
+		auto subscription = root >> wrap([&consumed] (const auto&) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			++consumed;
+		});
+
+		for (int index = 0; index < 5; ++index)
+			root.info("{}", index);
+		EXPECT_FALSE(root.get_dispatcher()->flush(std::chrono::milliseconds(1)));
+		EXPECT_TRUE(root.get_dispatcher()->flush(std::chrono::seconds(10)));
+		EXPECT_EQ(consumed.load(), 5);
+
+		for (int index = 0; index < 20; ++index)
+			root.info("{}", index);
+		const auto dropped = root.get_dispatcher()->shutdown(std::chrono::milliseconds(50));
+		const auto passed = consumed.load();
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		EXPECT_EQ(consumed.load(), passed);
+		EXPECT_GT(dropped, 0);
+		EXPECT_EQ(passed + dropped, 25);
+	}
 };
 
 TEST_F(shared_tags_logger_test_suite, empty)
@@ -222,3 +255,245 @@ TEST_F(shared_tags_logger_test_suite, check_logger_with_own_thread_consumer_with
 	EXPECT_EQ(get_message(check2[0]), "2");
 }
 
+TEST_F(shared_tags_logger_test_suite, check_shared_tags_logger_with_pooled_consumer)
+{
+	std::vector<shared_tags_logger::traits_t::tags_handle_t> check1;
+	std::vector<shared_tags_logger::traits_t::tags_handle_t> check2;
+
+	shared_tags_logger root;
+	root.debug("1");
+	{
+		auto pool = std::make_shared<loggerpp::thread_pool>(2);
+		auto subscription1 = root >> loggerpp::run_in_pool(pool, [&check1] (const auto& tags_handle) {
+			check1.push_back(tags_handle);
+		});
+		auto subscription2 = root >> loggerpp::run_in_pool() >> [&check2] (const auto& tags_handle) {
+			check2.push_back(tags_handle);
+		};
+		for (std::size_t index = 0; index < 100; ++index)
+			root.debug("{}", index);
+	}//waiting here while strands are finishing
+	root.debug("3");
+
+	ASSERT_EQ(check1.size(), 100);
+	ASSERT_EQ(check2.size(), 100);
+	for (std::size_t index = 0; index < 100; ++index)
+	{
+		EXPECT_EQ(get_message(check1[index]), std::to_string(index));
+		EXPECT_EQ(check1[index], check2[index]);
+	}
+}
+
+TEST_F(shared_tags_logger_test_suite, flush_and_shutdown_own_thread_consumer)
+{
+	check_flush_and_shutdown_of_queued_consumer([] (auto&& consumer) {
+		return loggerpp::run_own_thread(std::move(consumer));
+	});
+}
+
+TEST_F(shared_tags_logger_test_suite, flush_and_shutdown_pooled_consumer)
+{
+	auto pool = std::make_shared<loggerpp::thread_pool>(2);
+	check_flush_and_shutdown_of_queued_consumer([&pool] (auto&& consumer) {
+		return loggerpp::run_in_pool(pool, std::move(consumer));
+	});
+}
+
+#if defined(__linux__)
+TEST_F(shared_tags_logger_test_suite, check_own_thread_options)
+{
+	std::string name;
+
+	shared_tags_logger root;
+	{
+		loggerpp::thread_options options;
+		options.name = "own_thread";
+		auto subscription = root >> loggerpp::run_own_thread([&name] (const auto&) {
+			char buffer[16] = {};
+			::pthread_getname_np(::pthread_self(), buffer, sizeof(buffer));
+			name = buffer;
+		}, options);
+		root.info("test");
+	}
+	EXPECT_EQ(name, "own_thread");
+}
+#endif
+
+TEST_F(shared_tags_logger_test_suite, render_once_per_format)
+{
+	struct format_a {};
+	struct format_b {};
+
+	//records get the cache while several consumers share rendering
+	const auto tags = loggerpp::shared_tags_log_traits::make_tags_handle({
+		{"time", std::chrono::system_clock::now()},
+		{"level", loggerpp::level::info},
+		{"message", std::string("test")},
+	}, nullptr, true);
+
+	std::atomic_int renders {0};
+	const auto render = [&renders] (std::ostream& out) {
+		++renders;
+		out << "rendered" << std::endl;
+	};
+
+	std::ostringstream out1, out2, out3;
+	std::thread other([&] {
+		loggerpp::details::write_rendered<loggerpp::shared_tags_log_traits, format_a>(out1, tags, render);
+	});
+	loggerpp::details::write_rendered<loggerpp::shared_tags_log_traits, format_a>(out2, tags, render);
+	other.join();
+	EXPECT_EQ(renders, 1);
+	EXPECT_EQ(out1.str(), "rendered\n");
+	EXPECT_EQ(out2.str(), "rendered\n");
+
+	loggerpp::details::write_rendered<loggerpp::shared_tags_log_traits, format_b>(out3, tags, render);
+	EXPECT_EQ(renders, 2);
+
+	//without the cache in traits each consumer renders
+	loggerpp::details::write_rendered<loggerpp::default_log_traits, format_a>(out3, loggerpp::shared_tags_log_traits::extract_tags(tags), render);
+	EXPECT_EQ(renders, 3);
+}
+
+TEST_F(shared_tags_logger_test_suite, render_after_failed_render)
+{
+	struct format_a {};
+
+	loggerpp::details::render_cache cache;
+	EXPECT_THROW(cache.get<format_a>([] () -> std::string {
+		throw std::runtime_error("render");
+	}), std::runtime_error);
+	EXPECT_EQ(cache.get<format_a>([] {
+		return std::string("rendered");
+	}), "rendered");
+	EXPECT_EQ(cache.get<format_a>([] {
+		return std::string("again");
+	}), "rendered");
+}
+
+TEST_F(shared_tags_logger_test_suite, render_without_cache_for_single_consumer)
+{
+	const std::string path = "log.log";
+	::unlink(path.data());
+
+	std::vector<shared_tags_logger::tags_handle_t> check;
+	{
+		shared_tags_logger root;
+		auto subscription1 = root >> [&check] (const auto& tags_handle) {
+			check.push_back(tags_handle);
+		};
+		auto subscription2 = root >> loggerpp::build_base_file_log_consumer<loggerpp::shared_tags_log_traits>(path);
+		root.info("1");
+		root.get_dispatcher()->flush(std::chrono::seconds(5));
+
+		//console and file records start with the same head, so it is rendered once
+		auto subscription3 = root >> loggerpp::shared_tags_default_text_consumer;
+		root.info("2");
+	}
+	ASSERT_EQ(check.size(), 2);
+	EXPECT_EQ(loggerpp::shared_tags_log_traits::get_render_cache(check[0]), nullptr);
+	const auto cache = loggerpp::shared_tags_log_traits::get_render_cache(check[1]);
+	ASSERT_NE(cache, nullptr);
+	const auto& head = cache->get<loggerpp::details::text_head_format>([] {
+		ADD_FAILURE() << "the head is rendered twice";
+		return std::string();
+	});
+	EXPECT_EQ(head.substr(head.size() - 7), "\tinfo\t2");
+
+	//handles are plain shared tags
+	const std::shared_ptr<const logger::tags_t> plain = check[1];
+	const loggerpp::shared_tags_log_traits::tags_handle_t handle = std::make_shared<logger::tags_t>(*plain);
+	EXPECT_EQ(get_message(handle), "2");
+	EXPECT_EQ(loggerpp::shared_tags_log_traits::get_render_cache(handle), nullptr);
+	::unlink(path.data());
+}
+
+TEST_F(shared_tags_logger_test_suite, serialize_on_producer)
+{
+	const std::string path = "log.log";
+	::unlink(path.data());
+
+	std::atomic_int renders {0};
+	{
+		producer_text_logger root;
+		auto subscription1 = root >> loggerpp::build_base_file_log_consumer<loggerpp::producer_text_log_traits>(path);
+		auto subscription2 = root >> [&renders] (const auto& tags_handle) {
+			std::ostringstream out;
+			loggerpp::details::write_rendered<loggerpp::producer_text_log_traits, loggerpp::details::text_record_format>(out, tags_handle, [&renders] (std::ostream&) {
+				++renders;
+			});
+			EXPECT_EQ(out.str().substr(out.str().size() - 8), "\tinfo\t1\n");
+		};
+		root.info("1");
+	}
+	EXPECT_EQ(renders, 0);
+
+	std::ifstream file(path);
+	std::string line;
+	std::getline(file, line);
+	EXPECT_EQ(line.substr(line.size() - 7), "\tinfo\t1");
+	::unlink(path.data());
+}
+
+TEST_F(shared_tags_logger_test_suite, render_context_once)
+{
+	const auto context = std::make_shared<const loggerpp::details::context_cache>(2);
+	const auto make_record = [&context] (const std::string& message, const std::string& user) {
+		return loggerpp::shared_tags_log_traits::make_tags_handle({
+			{"time", std::chrono::system_clock::time_point{}},
+			{"level", loggerpp::level::info},
+			{"message", message},
+			{"request", std::int64_t{7}},
+			{"user", user},
+			{"extra", std::int64_t{1}},
+		}, context, false);
+	};
+
+	std::ostringstream out;
+	const auto first = make_record("1", "root");
+	loggerpp::details::write_text_record<loggerpp::shared_tags_log_traits>(out, *first, loggerpp::shared_tags_log_traits::get_context(first));
+	EXPECT_NE(out.str().find("\t1\trequest=7\tuser=root\textra=1\n"), std::string::npos);
+
+	//the context is rendered by the first record of logger
+	out.str({});
+	const auto second = make_record("2", "changed");
+	loggerpp::details::write_text_record<loggerpp::shared_tags_log_traits>(out, *second, loggerpp::shared_tags_log_traits::get_context(second));
+	EXPECT_NE(out.str().find("\t2\trequest=7\tuser=root\textra=1\n"), std::string::npos);
+}
+
+TEST_F(shared_tags_logger_test_suite, context_of_extended_logger)
+{
+	const std::string path = "log.log";
+	::unlink(path.data());
+
+	std::vector<shared_tags_logger::tags_handle_t> check;
+	{
+		shared_tags_logger root;
+		auto x = extend_logger(root, {{"request", std::int64_t{7}}, {"user", std::string("root")}});
+		auto subscription1 = root >> [&check] (const auto& tags_handle) {
+			check.push_back(tags_handle);
+		};
+		auto subscription2 = root >> loggerpp::build_base_file_log_consumer<loggerpp::shared_tags_log_traits>(path);
+		root.info("1");
+		x.info("2");
+		x.info("3");
+		x.info("4");
+		//a temporary logger logs once, so it doesn't make the context
+		(x | shared_tags_logger::tag_t{"extra", std::int64_t{1}}).info("5");
+	}
+	ASSERT_EQ(check.size(), 5);
+	EXPECT_EQ(loggerpp::shared_tags_log_traits::get_context(check[0]), nullptr);
+	EXPECT_EQ(loggerpp::shared_tags_log_traits::get_context(check[1]), nullptr);
+	ASSERT_NE(loggerpp::shared_tags_log_traits::get_context(check[2]), nullptr);
+	EXPECT_EQ(loggerpp::shared_tags_log_traits::get_context(check[2]), loggerpp::shared_tags_log_traits::get_context(check[3]));
+	EXPECT_EQ(loggerpp::shared_tags_log_traits::get_context(check[2])->count, 2);
+	EXPECT_EQ(loggerpp::shared_tags_log_traits::get_context(check[4]), nullptr);
+
+	std::ifstream file(path);
+	std::vector<std::string> lines;
+	for (std::string line; std::getline(file, line); )
+		lines.push_back(line.substr(line.find("\tinfo\t") + 6));
+	EXPECT_EQ(lines, (std::vector<std::string>{"1", "2\trequest=7\tuser=root", "3\trequest=7\tuser=root", "4\trequest=7\tuser=root",
+		"5\trequest=7\tuser=root\textra=1"}));
+	::unlink(path.data());
+}
@@ -0,0 +1,118 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/thread_pool.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+using namespace charivari_ltd;
+
+class thread_pool_test_suite :
+	public testing::Test
+{
+};
+
+TEST_F(thread_pool_test_suite, empty)
+{
+	loggerpp::thread_pool pool(2);
+	EXPECT_EQ(pool.get_threads_count(), 2);
+}
+
+TEST_F(thread_pool_test_suite, execute_all_tasks_before_destruct)
+{
+	std::atomic<std::size_t> counter {0};
+	{
+		loggerpp::thread_pool pool(3);
+		for (std::size_t index = 0; index < 1000; ++index)
+			pool.push([&counter] {
+				++counter;
+			});
+	}
+	EXPECT_EQ(counter, 1000);
+}
+
+TEST_F(thread_pool_test_suite, strand_keeps_order)
+{
+	auto pool = std::make_shared<loggerpp::thread_pool>(4);
+	std::vector<std::size_t> check1;
+	std::vector<std::size_t> check2;
+	{
+		loggerpp::strand strand1(pool);
+		loggerpp::strand strand2(pool);
+		for (std::size_t index = 0; index < 1000; ++index)
+		{
+			strand1.push([&check1, index] {
+				check1.push_back(index);
+			});
+			strand2.push([&check2, index] {
+				check2.push_back(index);
+			});
+		}
+	}//waiting here while strands are finishing
+
+	ASSERT_EQ(check1.size(), 1000);
+	ASSERT_EQ(check2.size(), 1000);
+	for (std::size_t index = 0; index < 1000; ++index)
+	{
+		EXPECT_EQ(check1[index], index);
+		EXPECT_EQ(check2[index], index);
+	}
+}
+
+TEST_F(thread_pool_test_suite, slow_strand_does_not_block_another)
+{
+	auto pool = std::make_shared<loggerpp::thread_pool>(2);
+	std::vector<std::size_t> check;
+	std::mutex mutex;
+	{
+		loggerpp::strand strand1(pool);
+		loggerpp::strand strand2(pool);
+		strand1.push([&check, &mutex] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			std::lock_guard<std::mutex> lock(mutex);
+			check.push_back(1);
+		});
+		strand2.push([&check, &mutex] {
+			std::lock_guard<std::mutex> lock(mutex);
+			check.push_back(2);
+		});
+	}
+
+	ASSERT_EQ(check.size(), 2);
+	EXPECT_EQ(check[0], 2);
+	EXPECT_EQ(check[1], 1);
+}
@@ -0,0 +1,134 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/binary_log_reader.h>
+#include <loggerpp/file_log_consumer.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace charivari_ltd;
+
+namespace
+{
+	void print_usage()
+	{
+		std::cerr
+			<< "usage: loggerpp_binlog [options] file...\n"
+			<< "  --from <seconds>   records since the time (seconds since epoch)\n"
+			<< "  --to <seconds>     records before the time\n"
+			<< "  --level <level>    records of the level; may be repeated\n"
+			<< "  --key <key>        records with the tag; may be repeated\n"
+			<< "  --index            print the index of blocks instead of records\n";
+	}
+
+	std::chrono::system_clock::time_point parse_time(const std::string& str)
+	{
+		const std::chrono::duration<double> seconds(std::stod(str));
+		return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(seconds));
+	}
+
+	void print_index(const loggerpp::binary_log_reader<loggerpp::default_log_traits>& reader)
+	{
+		for (const auto& block : reader.get_blocks())
+			std::cout << block.offset << '\t' << block.min_time << '\t' << block.max_time << '\t' << std::hex << block.levels << '\t' << block.key_bits << std::dec << '\n';
+	}
+} //namespace
+
+int main(int argc, char** argv)
+{
+	loggerpp::binary_log_query query;
+	std::vector<std::string> files;
+	bool index = false;
+
+	try {
+		for (int position = 1; position < argc; ++position)
+		{
+			const std::string arg = argv[position];
+			const auto value = [&] () -> std::string {
+				if (++position == argc)
+					throw std::invalid_argument(arg + " requires value");
+				return argv[position];
+			};
+
+			if (arg == "--from")
+				query.from = parse_time(value());
+			else if (arg == "--to")
+				query.to = parse_time(value());
+			else if (arg == "--level")
+			{
+				const auto name = value();
+				const auto lvl = loggerpp::parse_level(name);
+				if (!lvl)
+					throw std::invalid_argument("unknown level " + name);
+				query.levels.push_back(*lvl);
+			}
+			else if (arg == "--key")
+				query.keys.push_back(value());
+			else if (arg == "--index")
+				index = true;
+			else if (arg == "--help" || arg == "-h")
+			{
+				print_usage();
+				return 0;
+			}
+			else
+				files.push_back(arg);
+		}
+		if (files.empty())
+			throw std::invalid_argument("no files");
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		print_usage();
+		return 2;
+	}
+
+	try {
+		for (const auto& path : files)
+		{
+			loggerpp::binary_log_reader<loggerpp::default_log_traits> reader(path);
+			if (index)
+				print_index(reader);
+			else
+				reader.read(query, [] (const loggerpp::default_log_traits::tags_handle_t& tags) {
+					loggerpp::details::write_text_record<loggerpp::default_log_traits>(std::cout, tags);
+				});
+		}
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,92 @@
+// Project loggerpp
+//
+// MIT License
+//
+// Copyright (C) 2018 Dmitry Shatilov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Original sources:
+//   https://github.com/shatilov-diman/loggerpp/
+//   https://bitbucket.org/charivariltd/loggerpp/
+//
+// Author contacts:
+//   Dmitry Shatilov (e-mail: shatilov.diman@gmail.com; site: https://www.linkedin.com/in/shatilov)
+//
+//
+
+#include <loggerpp/log_merge.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace charivari_ltd;
+
+namespace
+{
+	void print_usage()
+	{
+		std::cerr
+			<< "usage: loggerpp_merge [-o output] file...\n"
+			<< "  merges text logs of file_log_consumer and binary logs by time\n";
+	}
+} //namespace
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> files;
+	std::string output;
+	for (int position = 1; position < argc; ++position)
+	{
+		const std::string arg = argv[position];
+		if (arg == "-o" && position + 1 < argc)
+			output = argv[++position];
+		else if (arg == "--help" || arg == "-h" || arg == "-o")
+		{
+			print_usage();
+			return arg == "-o" ? 2 : 0;
+		}
+		else
+			files.push_back(arg);
+	}
+	if (files.empty())
+	{
+		print_usage();
+		return 2;
+	}
+
+	try {
+		std::ofstream file;
+		if (!output.empty())
+		{
+			file.open(output);
+			if (!file)
+				throw std::runtime_error("can't open " + output);
+		}
+		std::ostream& out = output.empty() ? std::cout : file;
+		loggerpp::merge_logs(files, out);
+		out.flush();
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}